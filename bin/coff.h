@@ -46,4 +46,54 @@ struct scnhdr {
         unsigned short  s_nlnno;        /* number of gp histogram entries */
         long            s_flags;        /* flags */
       };
+
+/* The symbolic header, at f_symptr.  Only the external symbols are
+ * used, by coff2noff, to name the procedures for the PC profiler.
+ */
+typedef struct hdrr {
+        short   magic;          /* 0x7009 */
+        short   vstamp;         /* version stamp */
+        long    ilineMax;       /* line numbers */
+        long    cbLine;
+        long    cbLineOffset;
+        long    idnMax;         /* dense numbers */
+        long    cbDnOffset;
+        long    ipdMax;         /* procedure descriptors */
+        long    cbPdOffset;
+        long    isymMax;        /* local symbols */
+        long    cbSymOffset;
+        long    ioptMax;        /* optimization symbols */
+        long    cbOptOffset;
+        long    iauxMax;        /* auxiliary symbols */
+        long    cbAuxOffset;
+        long    issMax;         /* local strings */
+        long    cbSsOffset;
+        long    issExtMax;      /* external strings */
+        long    cbSsExtOffset;
+        long    ifdMax;         /* file descriptors */
+        long    cbFdOffset;
+        long    crfd;           /* relative file descriptors */
+        long    cbRfdOffset;
+        long    iextMax;        /* external symbols */
+        long    cbExtOffset;
+      } HDRR;
+
+/* An external symbol.  The type and storage class are bit fields of
+ * "bits", in the little endian order of the MIPSEL tools.
+ */
+typedef struct extr {
+        unsigned short  flags;  /* jmptbl, cobol_main, weakext */
+        short   ifd;            /* file it was defined in */
+        long    iss;            /* index of its name in the strings */
+        long    value;          /* address */
+        unsigned long   bits;   /* st:6, sc:5, reserved:1, index:20 */
+      } EXTR;
+
+#define SymType(bits)   ((bits) & 0x3f)
+#define SymClass(bits)  (((bits) >> 6) & 0x1f)
+
+#define stLabel         5       /* SymType */
+#define stProc          6
+#define stStaticProc    14
+#define scText          1       /* SymClass */
  
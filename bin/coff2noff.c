@@ -89,6 +89,81 @@ void Write(int fd, char *buf, int nBytes)
     }
 }
 
+/* Write the procedures in the external symbol table of the COFF file
+ * to "<noffName>.sym", sorted by address, for the PC profiler.
+ * Does nothing if the COFF file has been stripped.
+ */
+void WriteSymbols(int fdIn, struct filehdr *fileh, char *noffName)
+{
+    HDRR symh;
+    EXTR *ext;
+    NoffSymbol *syms, sym;
+    NoffSymHeader symH;
+    char *strings, *names, *symFileName;
+    int fdSym, numExt, numSyms, namesSize, i, j;
+
+    if (fileh->f_symptr == 0) {
+	printf("No symbol table, so no %s.sym\n", noffName);
+	return;
+    }
+    lseek(fdIn, WordToHost(fileh->f_symptr), 0);
+    ReadStruct(fdIn, symh);
+    numExt = WordToHost(symh.iextMax);
+
+    strings = malloc(WordToHost(symh.issExtMax) + 1);
+    lseek(fdIn, WordToHost(symh.cbSsExtOffset), 0);
+    Read(fdIn, strings, WordToHost(symh.issExtMax));
+    strings[WordToHost(symh.issExtMax)] = '\0';
+
+    ext = (EXTR *)malloc(numExt * sizeof(EXTR) + 1);
+    lseek(fdIn, WordToHost(symh.cbExtOffset), 0);
+    Read(fdIn, (char *) ext, numExt * sizeof(EXTR));
+
+    syms = (NoffSymbol *)malloc(numExt * sizeof(NoffSymbol) + 1);
+    names = malloc(WordToHost(symh.issExtMax) + 1);
+    numSyms = 0;
+    namesSize = 0;
+    for (i = 0; i < numExt; i++) {
+	unsigned int bits = WordToHost(ext[i].bits);
+	int st = SymType(bits);
+	char *name = &strings[WordToHost(ext[i].iss)];
+
+	if (SymClass(bits) != scText || (st != stProc && st != stStaticProc
+						&& st != stLabel))
+	    continue;
+	sym.value = WordToHost(ext[i].value);
+	sym.name = namesSize;
+	strcpy(&names[namesSize], name);
+	namesSize += strlen(name) + 1;
+	/* insertion sort: there are only a few hundred */
+	for (j = numSyms; j > 0 && syms[j - 1].value > sym.value; j--)
+	    syms[j] = syms[j - 1];
+	syms[j] = sym;
+	numSyms++;
+    }
+
+    symFileName = malloc(strlen(noffName) + 5);
+    sprintf(symFileName, "%s.sym", noffName);
+    fdSym = open(symFileName, O_WRONLY|O_CREAT|O_TRUNC , 0666);
+    if (fdSym == -1) {
+	perror(symFileName);
+	return;
+    }
+    symH.magic = NOFFSYMMAGIC;
+    symH.numSymbols = numSyms;
+    symH.namesSize = namesSize;
+    Write(fdSym, (char *)&symH, sizeof(NoffSymHeader));
+    Write(fdSym, (char *)syms, numSyms * sizeof(NoffSymbol));
+    Write(fdSym, names, namesSize);
+    close(fdSym);
+    printf("%d procedures written to %s\n", numSyms, symFileName);
+    free(strings);
+    free((char *) ext);
+    free((char *) syms);
+    free(names);
+    free(symFileName);
+}
+
 main (int argc, char **argv)
 {
     int fdIn, fdOut, numsections, i, inNoffFile;
@@ -221,6 +296,7 @@ main (int argc, char **argv)
     }
     lseek(fdOut, 0, 0);
     Write(fdOut, (char *)&noffH, sizeof(NoffHeader));
+    WriteSymbols(fdIn, &fileh, argv[2]);
     close(fdIn);
     close(fdOut);
     exit(0);
@@ -23,3 +23,22 @@ typedef struct noffHeader {
 				 * should be zero'ed before use 
 				 */
 } NoffHeader;
+
+/* coff2noff also writes the procedure names of the program, which the
+ * NOFF file doesn't need, into "<noff file>.sym", for the PC profiler
+ * ("nachos -pc").  The file is a NoffSymHeader, then numSymbols
+ * NoffSymbol's sorted by address, then the names, each ending in '\0'.
+ */
+
+#define NOFFSYMMAGIC	0x4e53594d	/* "NSYM" */
+
+typedef struct noffSymbol {
+   int value;			/* address of the procedure */
+   int name;			/* offset of its name in the names */
+} NoffSymbol;
+
+typedef struct noffSymHeader {
+   int magic;			/* should be NOFFSYMMAGIC */
+   int numSymbols;
+   int namesSize;		/* bytes of names */
+} NoffSymHeader;
@@ -0,0 +1,183 @@
+/* tracedump.c 
+ *
+ * This program reads a trace file written by "nachos -tr <flags>", and
+ * prints its records as text, one per line, oldest first:
+ *
+ *	<time> <cpu> <thread id>  <event>
+ *
+ * With -j, it writes the trace instead in the JSON format read by the
+ * Chrome (chrome://tracing) and Perfetto timeline viewers.  There is a
+ * track for each CPU, showing which thread ran when, and interrupts;
+ * a track for each thread, with its system calls and other events;
+ * and a track for the disk.  Simulated ticks are shown as microseconds.
+ *
+ * The names of the events, how to print their arguments, and which
+ * track they go on are stored in the trace file itself, so this
+ * program doesn't need to be changed when trace points are added.
+ *
+ * Usage: tracedump [-j] [nachos.trace]
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation 
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#define MAIN
+#include "copyright.h" 
+#undef MAIN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+#define MaxTracks	65536		/* tracks of each kind we follow */
+
+/* The three kinds of tracks, as "processes" of the timeline */
+#define CPUProcess	0
+#define ThreadProcess	1
+#define DiskProcess	2
+
+static char *processNames[] = { "CPUs", "threads", "devices" };
+
+/* For each track: has it been named yet, and how many intervals are
+ * open on it.  An end without a begin (because the trace started, or
+ * wrapped around, in the middle of an interval) is dropped.
+ */
+static char named[3][MaxTracks];
+static int open[3][MaxTracks];
+
+static int firstEvent = 1;
+
+/* Start a JSON event, with a comma before all but the first */
+static void
+JSONStart()
+{
+    printf(firstEvent ? "\n  " : ",\n  ");
+    firstEvent = 0;
+}
+
+/* Name a track the first time it is used */
+static void
+NameTrack(int pid, int tid)
+{
+    if (named[pid][tid])
+	return;
+    named[pid][tid] = 1;
+    JSONStart();
+    printf("{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, "
+	"\"tid\": %d, \"args\": {\"name\": \"", pid, tid);
+    if (pid == CPUProcess)
+	printf("CPU %d", tid);
+    else if (pid == ThreadProcess)
+	printf("thread %d", tid);
+    else
+	printf("disk");
+    printf("\"}}");
+}
+
+/* Write one record as a JSON event */
+static void
+JSONRecord(TraceRecord *rec, TraceEventInfo *info)
+{
+    int pid, tid;
+
+    switch (info->track) {
+      case TraceTrackCPU:	pid = CPUProcess; tid = rec->cpu; break;
+      case TraceTrackThread:	pid = ThreadProcess; tid = rec->tid; break;
+      default:			pid = DiskProcess; tid = 0; break;
+    }
+    if (tid < 0 || tid >= MaxTracks)
+	return;
+    if (info->phase == TracePhaseEnd) {
+	if (open[pid][tid] == 0)
+	    return;
+	open[pid][tid]--;
+    } else if (info->phase == TracePhaseBegin)
+	open[pid][tid]++;
+
+    NameTrack(pid, tid);
+    JSONStart();
+    printf("{\"name\": \"");
+    printf(info->format, rec->arg[0], rec->arg[1], rec->arg[2]);
+    printf("\", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %d, \"pid\": %d, "
+	"\"tid\": %d", info->name, info->phase, rec->time, pid, tid);
+    if (info->phase == TracePhaseInstant)
+	printf(", \"s\": \"t\"");
+    printf(", \"args\": {\"cpu\": %d, \"thread\": %d}}", rec->cpu, rec->tid);
+}
+
+int
+main(int argc, char **argv)
+{
+    char *name = TraceFileName;
+    int json = 0;
+    FILE *fp;
+    TraceHeader hdr;
+    TraceEventInfo *events, *info;
+    TraceRecord rec;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+	if (!strcmp(argv[i], "-j"))
+	    json = 1;
+	else
+	    name = argv[i];
+    }
+    if ((fp = fopen(name, "rb")) == NULL) {
+	perror(name);
+	exit(1);
+    }
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != TraceMagic
+	    || hdr.version != TraceVersion || hdr.numEvents <= 0) {
+	fprintf(stderr, "%s: not a Nachos trace file, or an old one\n", name);
+	exit(1);
+    }
+    events = (TraceEventInfo *) malloc(hdr.numEvents * sizeof(TraceEventInfo));
+    if (fread(events, sizeof(TraceEventInfo), hdr.numEvents, fp)
+	    != hdr.numEvents) {
+	fprintf(stderr, "%s: truncated\n", name);
+	exit(1);
+    }
+    for (i = 0; i < hdr.numEvents; i++) {	/* in case of garbage */
+	events[i].name[sizeof(events[i].name) - 1] = '\0';
+	events[i].format[sizeof(events[i].format) - 1] = '\0';
+    }
+
+    if (json) {
+	printf("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for (i = 0; i < 3; i++) {
+	    JSONStart();
+	    printf("{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+		"\"args\": {\"name\": \"%s\"}}", i, processNames[i]);
+	}
+    } else {
+	if (hdr.numLost > 0)
+	    printf("(%d earlier records were lost)\n", hdr.numLost);
+	printf("%10s %3s %5s  event\n", "time", "cpu", "tid");
+    }
+    for (i = 0; i < hdr.numRecords; i++) {
+	if (fread(&rec, sizeof(rec), 1, fp) != 1) {
+	    fprintf(stderr, "%s: truncated after %d records\n", name, i);
+	    exit(1);
+	}
+	if (rec.event < 0 || rec.event >= hdr.numEvents) {
+	    fprintf(stderr, "%s: unknown event %d at time %d\n", name,
+		rec.event, rec.time);
+	    continue;
+	}
+	info = &events[rec.event];
+	if (json) {
+	    JSONRecord(&rec, info);
+	    continue;
+	}
+	printf("%10d %3d %5d  ", rec.time, rec.cpu, rec.tid);
+	printf(info->format, rec.arg[0], rec.arg[1], rec.arg[2]);
+	printf("\n");
+    }
+    if (json)
+	printf("\n]}\n");
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// cache.cc
+//	Routines to emulate a set associative processor cache.
+//	See cache.h for what is modelled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cache.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.  The sizes must be powers of two.
+//
+//	"debugName" is the name of the cache, for printing.
+//	"size" is the capacity of the cache, in bytes.
+//	"numWays" is the number of lines in each set.
+//	"lineSize" is the size of a line, in bytes.
+//	"isWriteBack" is TRUE for a write-back, write-allocate cache, and
+//		FALSE for a write-through one.
+//----------------------------------------------------------------------
+
+Cache::Cache(char *debugName, int size, int numWays, int lineSize,
+	     bool isWriteBack)
+{
+    ASSERT(lineSize >= 4 && (lineSize & (lineSize - 1)) == 0);
+    ASSERT(numWays >= 1 && (numWays & (numWays - 1)) == 0);
+    ASSERT(size >= numWays * lineSize && (size & (size - 1)) == 0);
+
+    name = debugName;
+    assoc = numWays;
+    writeBack = isWriteBack;
+    numSets = size / (assoc * lineSize);
+    for (lineShift = 0; (1 << lineShift) < lineSize; lineShift++)
+	;
+    lines = new CacheLine[numSets * assoc];
+    for (int i = 0; i < numSets * assoc; i++) {
+	lines[i].valid = FALSE;
+	lines[i].dirty = FALSE;
+	lines[i].lastUsed = 0;
+    }
+    useCount = 0;
+    accesses = misses = writes = writeMisses = writeBacks = memoryWrites = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] lines;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Look up the line holding "physAddr", and bring it in if it isn't
+//	there (except for a write to a write-through cache), replacing
+//	the least recently used line of its set.
+//
+//	Returns TRUE if the access hit.
+//
+//	"physAddr" is the physical address accessed.
+//	"writing" is TRUE for a store.
+//----------------------------------------------------------------------
+
+bool
+Cache::Access(int physAddr, bool writing)
+{
+    unsigned int line = (unsigned int) physAddr >> lineShift;
+    unsigned int tag = line / numSets;
+    CacheLine *set = &lines[(line % numSets) * assoc];
+    CacheLine *victim = &set[0];
+    int i;
+
+    accesses++;
+    useCount++;
+    if (writing) {
+	writes++;
+	if (!writeBack)
+	    memoryWrites++;
+    }
+    for (i = 0; i < assoc; i++) {
+	if (set[i].valid && set[i].tag == tag) {
+	    set[i].lastUsed = useCount;
+	    if (writing && writeBack)
+		set[i].dirty = TRUE;
+	    return TRUE;
+	}
+	if (victim->valid && (!set[i].valid
+				|| set[i].lastUsed < victim->lastUsed))
+	    victim = &set[i];
+    }
+
+    misses++;
+    if (writing) {
+	writeMisses++;
+	if (!writeBack)
+	    return FALSE;		// no write allocate
+    }
+    if (victim->valid && victim->dirty)
+	writeBacks++;
+    victim->tag = tag;
+    victim->valid = TRUE;
+    victim->dirty = writing;
+    victim->lastUsed = useCount;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Cache::Print
+// 	Print the configuration of the cache, and how well it did.
+//----------------------------------------------------------------------
+
+void
+Cache::Print()
+{
+    printf("%s: %d bytes, %d-way, %d byte lines, %s\n", name,
+	numSets * assoc << lineShift, assoc, 1 << lineShift,
+	writeBack ? "write-back" : "write-through");
+    printf("  accesses %d, misses %d, hit rate %.2f%%\n", accesses, misses,
+	(accesses > 0) ? (accesses - misses) * 100.0 / accesses : 0.0);
+    printf("  writes %d, write misses %d, %s %d\n", writes, writeMisses,
+	writeBack ? "write-backs" : "memory writes",
+	writeBack ? writeBacks : memoryWrites);
+}
@@ -0,0 +1,71 @@
+// cache.h
+//	Data structures to emulate a processor cache in front of main
+//	memory.
+//
+//	The cache only keeps tags, not data: main memory always holds
+//	the current contents, and the cache decides whether an access
+//	would have hit.  It is set associative with LRU replacement,
+//	and is indexed and tagged with physical addresses, so it needn't
+//	be flushed on a context switch.
+//
+//	A write-back cache allocates a line on a write miss, and counts
+//	a write-back when a dirty line is replaced.  A write-through
+//	cache doesn't allocate on a write miss; every write goes to
+//	memory, through a write buffer that never stalls the CPU.
+//
+//	The machine (see machine.h) can have one cache for instructions
+//	and data, or one of each.  Only the accesses of user instructions
+//	go through them; the kernel copies to and from user memory
+//	directly.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// One cache line: which memory line it holds, if any
+class CacheLine {
+  public:
+    unsigned int tag;		// line address / number of sets
+    bool valid;
+    bool dirty;			// written since loaded (write-back only)
+    int lastUsed;		// access count when last used, for LRU
+};
+
+// The following class defines a cache.
+
+class Cache {
+  public:
+    Cache(char *debugName, int size, int numWays, int lineSize,
+	  bool isWriteBack);	// an empty cache of "size" bytes, with
+				// "numWays" lines of "lineSize" bytes per set
+    ~Cache();
+
+    bool Access(int physAddr, bool writing);
+				// look up one access; return TRUE if it hit
+    bool IsWriteBack() { return writeBack; }
+    void Print();		// print the hit rate
+
+    int accesses;		// all accesses ...
+    int misses;			// ... of which missed
+    int writes;			// writes ...
+    int writeMisses;		// ... of which missed
+    int writeBacks;		// dirty lines replaced
+    int memoryWrites;		// writes passed through (write-through only)
+
+  private:
+    char *name;
+    int numSets;
+    int assoc;
+    int lineShift;		// log2 of the line size
+    bool writeBack;
+    CacheLine *lines;		// numSets sets of assoc lines
+    int useCount;		// accesses so far, to order them
+};
+
+#endif // CACHE_H
@@ -16,6 +16,7 @@
 #include "copyright.h"
 #include "console.h"
 #include "system.h"
+#include "replay.h"
 
 // Dummy functions because C++ is weird about pointers to member functions
 static void ConsoleReadPoll(int c) 
@@ -87,17 +88,25 @@ void
 Console::CheckCharAvail()
 {
     char c;
+    bool avail;
 
     // schedule the next time to poll for a packet
     interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
 			ConsoleReadInt);
 
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
+    // do nothing if character is already buffered
+    if (incoming != EOF)
+	return;
 
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    // or if none to be read; when replaying, the log says whether
+    // one was typed, and what it was
+    avail = (replayMode != ReplayReplaying) && PollFile(readFileNo);
+    if (avail)
+	Read(readFileNo, &c, sizeof(char));
+    if (!ReplayInput(ReplayConsole, &c, sizeof(char), avail))
+	return;
+
+    // otherwise, tell user about it
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
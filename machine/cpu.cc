@@ -0,0 +1,317 @@
+// cpu.cc
+//	Routines to emulate the processors of a multiprocessor.  See
+//	cpu.h for how they are simulated.
+//
+//	Handing a CPU to its host thread and back: the kernel sets
+//	hostState to HostRunning, and the host thread, when it has run
+//	its instructions, to HostDone.  Either side waits for the other
+//	with HostWait.  The Machine belongs to whichever side was handed
+//	it last, so neither needs a lock to use it.
+//
+//	TLB shootdown: when an address space's pages are given back, any
+//	CPU whose TLB may still hold entries for it must flush them, or
+//	it could reach frames that now belong to someone else.  The
+//	current CPU flushes at once; the others are sent an
+//	inter-processor interrupt, which they act on the next time they
+//	are dispatched.  A CPU running user code on its host thread
+//	never holds entries for a space being freed: it flushed its TLB
+//	when it was given a thread of its current space, which is alive.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "system.h"
+
+bool hostCPUs = FALSE;
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize a processor, idle.  Its Machine comes later, once
+//	there is one.
+//
+//	"cpuId" is the number of the processor.
+//----------------------------------------------------------------------
+
+CPU::CPU(int cpuId)
+{
+    id = cpuId;
+    clock = 0;
+    idleTicks = 0;
+    numDispatches = 0;
+    numSteals = 0;
+    userThread = NULL;
+#ifdef USER_PROGRAM
+    machine = NULL;
+    hostState = HostIdle;
+    hostTicks = 0;
+    numBatches = 0;
+#endif
+#ifdef USE_TLB
+    tlbSpace = NULL;
+    shootdown = FALSE;
+    numShootdowns = 0;
+#endif
+}
+
+//----------------------------------------------------------------------
+// CPU::Print
+// 	Print the statistics for this processor.
+//----------------------------------------------------------------------
+
+void
+CPU::Print()
+{
+    printf("CPU %d: busy %d, idle %d, dispatches %d, steals %d", id,
+	clock - idleTicks, idleTicks, numDispatches, numSteals);
+#ifdef USER_PROGRAM
+    if (hostCPUs)
+	printf(", host batches %d", numBatches);
+#endif
+#ifdef USE_TLB
+    printf(", TLB shootdowns %d", numShootdowns);
+#endif
+    printf("\n");
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// CPUHostThread
+// 	The host thread of a CPU.
+//
+//	"which" is the number of the CPU.
+//----------------------------------------------------------------------
+
+static void
+CPUHostThread(int which)
+{
+    cpus[which]->HostLoop();
+}
+
+//----------------------------------------------------------------------
+// StartHostCPUs
+// 	Give each CPU a host thread to run user code on.  From now on,
+//	Machine::Run hands the CPU to it, instead of running the
+//	instructions itself.
+//----------------------------------------------------------------------
+
+void
+StartHostCPUs()
+{
+    hostCPUs = TRUE;
+    for (int i = 0; i < numCPUs; i++)
+	StartHostThread(CPUHostThread, i);
+}
+
+//----------------------------------------------------------------------
+// CPU::HostLoop
+// 	What the host thread of this CPU does: wait to be handed the
+//	Machine, run user instructions on it, hand it back, and so on.
+//----------------------------------------------------------------------
+
+void
+CPU::HostLoop()
+{
+    Instruction *instr = new Instruction;  // storage for decoded instruction
+    int ticks;
+
+    HostLock();
+    for (;;) {
+	while (hostState != HostRunning)
+	    HostWait();
+	HostUnlock();
+	ticks = machine->RunOnHost(instr, HostBatchTicks);
+	HostLock();
+	hostTicks = ticks;
+	hostState = HostDone;
+	HostWakeAll();
+    }
+}
+
+//----------------------------------------------------------------------
+// CPU::RunUser
+// 	Run the user code of the current thread, on the host thread of
+//	this, the current CPU, until it stops.  Meanwhile the thread
+//	sleeps, and the kernel runs other threads on the other CPUs.
+//	Return the exception that stopped it, for the caller to take
+//	once we have a CPU again -- which need not be this one -- or
+//	NoException.
+//
+//	Called from Machine::Run, in place of running one instruction;
+//	like that, the last instruction still needs its tick.
+//----------------------------------------------------------------------
+
+ExceptionType
+CPU::RunUser()
+{
+    Thread *thread = currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ExceptionType trap;
+
+    ASSERT(this == currentCPU && userThread == NULL);
+    interrupt->setStatus(SystemMode);	// handing over is kernel work
+    userThread = thread;
+    numBatches++;
+    HostLock();
+    hostState = HostRunning;
+    HostWakeAll();
+    HostUnlock();
+    thread->Sleep();			// until Collect makes us ready
+    (void) interrupt->SetLevel(oldLevel);
+    interrupt->setStatus(UserMode);
+    trap = thread->hostTrap;
+    thread->hostTrap = NoException;
+    return trap;
+}
+
+//----------------------------------------------------------------------
+// CPU::Collect
+// 	The host thread of this CPU has stopped running user code.
+//	Catch up with what it did: add the time it took to our clock,
+//	charge the thread for it and for what it used, and save the
+//	thread's registers, since another thread may use ours before it
+//	runs again.  Then make it ready.
+//
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+CPU::Collect()
+{
+    Thread *thread = userThread;
+    int ticks = hostTicks - UserTick;	// Machine::Run adds the last one
+
+    if (this == currentCPU)
+	stats->totalTicks += ticks;
+    else
+	clock += ticks;
+    stats->userTicks += ticks;
+    stats->cacheStallTicks += machine->hostStall;
+    thread->AddUsage(ResUserTicks, ticks);
+    for (int r = 0; r < NumResources; r++)
+	if (machine->hostUsage.count[r] != 0) {
+	    thread->AddUsage((Resource) r, machine->hostUsage.count[r]);
+	    machine->hostUsage.count[r] = 0;
+	}
+    //还在当前CPU上的线程，由Scheduler::Account按时钟结算
+    if (thread != currentThread)
+	thread->cpuTicks += ticks;
+    thread->hostTrap = machine->hostTrap;
+    thread->SaveUserState(machine);
+    userThread = NULL;
+    scheduler->ReadyToRun(thread);
+    thread->readyTime = CPUTime(this);
+}
+
+//----------------------------------------------------------------------
+// CollectCPUs
+// 	Collect the CPUs whose host threads have stopped, making their
+//	threads ready.  Return TRUE if there were any.
+//
+//	"wait" -- if no host thread has stopped, but some are running,
+//		wait for one of them
+//----------------------------------------------------------------------
+
+bool
+CollectCPUs(bool wait)
+{
+    bool done[MaxCPUs], any = FALSE, running;
+    int i;
+
+    HostLock();
+    for (;;) {
+	running = FALSE;
+	for (i = 0; i < numCPUs; i++) {
+	    done[i] = (cpus[i]->hostState == HostDone);
+	    if (done[i]) {
+		cpus[i]->hostState = HostIdle;
+		any = TRUE;
+	    } else if (cpus[i]->hostState == HostRunning)
+		running = TRUE;
+	}
+	if (any || !wait || !running)
+	    break;
+	HostWait();
+    }
+    HostUnlock();
+    for (i = 0; i < numCPUs; i++)
+	if (done[i])
+	    cpus[i]->Collect();
+    return any;
+}
+
+//----------------------------------------------------------------------
+// StopCPUs
+// 	Nachos is halting: wait for the host threads still running user
+//	code, count the time they took, and don't start them again.
+//----------------------------------------------------------------------
+
+void
+StopCPUs()
+{
+    bool running;
+    int i;
+
+    HostLock();
+    do {
+	running = FALSE;
+	for (i = 0; i < numCPUs; i++)
+	    if (cpus[i]->hostState == HostRunning)
+		running = TRUE;
+	if (running)
+	    HostWait();
+    } while (running);
+    for (i = 0; i < numCPUs; i++) {
+	if (cpus[i]->hostState == HostDone)
+	    cpus[i]->clock += cpus[i]->hostTicks;
+	cpus[i]->hostState = HostStopped;
+    }
+    HostUnlock();
+}
+#endif
+
+#ifdef USE_TLB
+//----------------------------------------------------------------------
+// CPU::FlushTLB
+// 	Invalidate the TLB entries of this processor.
+//----------------------------------------------------------------------
+
+void
+CPU::FlushTLB()
+{
+    if (machine->tlb == NULL)
+	return;
+    for (int i = 0; i < TLBSize; i++)
+	machine->tlb[i].valid = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ShootdownTLB
+// 	Make sure no TLB holds entries for "space" any more: flush the
+//	current CPU's TLB if it has some, and interrupt the other CPUs
+//	that may, so they flush theirs before they next run.
+//
+//	"space" is the address space whose mappings are going away.
+//----------------------------------------------------------------------
+
+void
+ShootdownTLB(AddrSpace *space)
+{
+    for (int i = 0; i < numCPUs; i++) {
+	CPU *cpu = cpus[i];
+
+	if (cpu->tlbSpace != space)
+	    continue;
+	cpu->tlbSpace = NULL;
+	if (cpu == currentCPU) {
+	    cpu->FlushTLB();
+	} else {
+	    DEBUG('t', "TLB shootdown interrupt to CPU %d\n", cpu->id);
+	    cpu->shootdown = TRUE;
+	    cpu->numShootdowns++;
+	}
+    }
+}
+#endif
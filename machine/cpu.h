@@ -0,0 +1,125 @@
+// cpu.h
+//	Data structures to emulate the processors of a shared-memory
+//	multiprocessor.
+//
+//	Nachos normally simulates a single CPU.  With "-cpus N" it
+//	simulates N, which share main memory, but each have their own
+//	clock, their own run queue (see scheduler.h) and, for user
+//	programs, their own Machine: registers, TLB and caches.
+//
+//	The kernel runs on the host thread Nachos started on.  Its
+//	threads are coroutines there, which get mutual exclusion by
+//	disabling interrupts, so the whole kernel is one critical
+//	section -- a big kernel lock -- and the scheduler and the
+//	virtual memory code need no locks of their own.
+//
+//	User code runs on host threads of its own, one per CPU.  When a
+//	thread goes to run user code, it hands its CPU's Machine to the
+//	CPU's host thread, and sleeps; the kernel goes on running other
+//	threads, on the CPUs that are free.  The host thread runs up to
+//	HostBatchTicks of instructions, stopping early if one raises an
+//	exception; a TLB miss on a page that is in memory is refilled
+//	from the page table there and then, as hardware would.  When it
+//	stops, the kernel adds the time taken to the CPU's clock and
+//	makes the thread ready again; once dispatched, the thread takes
+//	the exception, and any interrupts that came due meanwhile fire.
+//	So N CPUs run user programs on up to N host cores, and only the
+//	kernel is serialized.  Which CPU gets there first depends on the
+//	host, so such runs are not repeatable, and the CPUs' accesses to
+//	shared memory are not ordered, as on real hardware.
+//
+//	Without user programs, when single-stepping them, when sampling
+//	their PCs (-pc), and when recording or replaying a run, the CPUs
+//	instead take turns on the one host thread, a time slice at a
+//	time, always the one whose clock is furthest behind, so that
+//	their clocks stay within a slice of each other.
+//
+//	The current CPU is the one whose thread the kernel is running.
+//	Its Machine is "machine", and its clock stats->totalTicks; the
+//	others keep their clocks here.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#ifdef USER_PROGRAM
+#include "machine.h"
+class AddrSpace;
+#endif
+class Thread;
+
+#define MaxCPUs		16	// most processors we simulate
+#define HostBatchTicks	10000	// most user time a host thread runs
+				// before handing the CPU back
+
+// What a CPU's host thread is doing; only changed holding HostLock
+enum HostState { HostIdle, HostRunning, HostDone, HostStopped };
+
+// The following class defines one simulated processor.
+
+class CPU {
+  public:
+    CPU(int cpuId);		// initialize an idle processor
+    ~CPU() {}
+
+    void Print();		// print what this processor did
+
+    int id;			// 0 .. numCPUs-1
+    int clock;			// this processor's time, saved while
+				// another one is current
+    int idleTicks;		// time spent with nothing to run
+    int numDispatches;		// threads given this processor
+    int numSteals;		// threads taken from other processors
+
+    Thread *userThread;		// thread whose user code our host
+				// thread is running; NULL if none
+
+#ifdef USER_PROGRAM
+    Machine *machine;		// our registers, TLB and caches
+
+    ExceptionType RunUser();	// run currentThread's user code on our
+				// host thread for a while; return the
+				// exception it stopped on
+    void Collect();		// our host thread has stopped; make
+				// userThread ready again
+    void HostLoop();		// what our host thread does; never
+				// returns
+
+    HostState hostState;
+    int hostTicks;		// time the host thread last ran for
+    int numBatches;		// times it has run user code
+#endif
+
+#ifdef USE_TLB
+    void FlushTLB();		// invalidate our TLB
+
+    AddrSpace *tlbSpace;	// address space the TLB entries are for
+    bool shootdown;		// another CPU asked us to flush the TLB
+    int numShootdowns;		// number of such requests
+#endif
+};
+
+extern bool hostCPUs;		// do the CPUs run user code on host
+				// threads?
+
+#ifdef USER_PROGRAM
+extern void StartHostCPUs();	// give each CPU a host thread
+extern bool CollectCPUs(bool wait);	// make ready the threads whose
+				// host threads have stopped; if "wait",
+				// wait for one, if any are running
+extern void StopCPUs();		// wait for the host threads to stop,
+				// and keep them stopped
+#endif
+
+#ifdef USE_TLB
+extern void ShootdownTLB(AddrSpace *space);	// flush every TLB
+						// holding entries for space
+#endif
+
+#endif // CPU_H
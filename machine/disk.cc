@@ -134,6 +134,8 @@ Disk::ReadRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskReads++;
+    currentThread->AddUsage(ResDiskReads, 1);
+    TRACE('d', TraceDiskRequest, sectorNumber, 0, ticks);
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
@@ -154,6 +156,8 @@ Disk::WriteRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     stats->numDiskWrites++;
+    currentThread->AddUsage(ResDiskWrites, 1);
+    TRACE('d', TraceDiskRequest, sectorNumber, 1, ticks);
     interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
 }
 
@@ -167,6 +171,7 @@ void
 Disk::HandleInterrupt ()
 { 
     active = FALSE;
+    TRACE('d', TraceDiskDone, 0, 0, 0);
     (*handler)(handlerArg);
 }
 
@@ -23,12 +23,60 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "system.h"
+#include "replay.h"
+#ifdef USER_PROGRAM
+#include "pcprof.h"
+#endif
 
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "elevator", "network send",
+			"network recv", "scheduler alarm"};
+
+// A PendingInterrupt is allocated on every Schedule (the timer alone
+// re-schedules itself forever), so fired interrupts are kept on a
+// free list and handed out again, rather than going back to the heap.
+static PendingInterrupt *freeInterrupts = NULL;
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator new
+// 	Allocate storage for a pending interrupt, from the free list if
+//	there is anything on it, otherwise from the heap.
+//----------------------------------------------------------------------
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    PendingInterrupt *toOccur;
+
+    ASSERT(size == sizeof(PendingInterrupt));
+    if (freeInterrupts != NULL) {
+	toOccur = freeInterrupts;
+	freeInterrupts = toOccur->nextFree;
+	stats->numPendingReuses++;
+    } else {
+	toOccur = (PendingInterrupt *) ::operator new(size);
+	stats->numPendingAllocs++;
+    }
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// PendingInterrupt::operator delete
+// 	Put a pending interrupt's storage on the free list.  It is never
+//	given back to the heap.
+//----------------------------------------------------------------------
+
+void
+PendingInterrupt::operator delete(void *p)
+{
+    PendingInterrupt *toOccur = (PendingInterrupt *) p;
+
+    toOccur->nextFree = freeInterrupts;
+    freeInterrupts = toOccur;
+}
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -48,6 +96,182 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
     arg = param;
     when = time;
     type = kind;
+    seq = 0;
+}
+
+#define PendingQueueInitialSize	16	// grown by doubling
+
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+// 	Initialize an empty queue of pending interrupts.
+//----------------------------------------------------------------------
+
+PendingQueue::PendingQueue()
+{
+    capacity = PendingQueueInitialSize;
+    heap = new PendingInterrupt *[capacity];
+    numInQueue = 0;
+    nextSeq = 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+// 	De-allocate the queue.  As with List, the interrupts still on it
+//	are not de-allocated -- that is up to the owner.
+//----------------------------------------------------------------------
+
+PendingQueue::~PendingQueue()
+{
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Before
+// 	Return TRUE if "a" is to fire before "b": it is due earlier, or
+//	it is due at the same time but was scheduled first.
+//----------------------------------------------------------------------
+
+bool
+PendingQueue::Before(PendingInterrupt *a, PendingInterrupt *b)
+{
+    if (a->when != b->when)
+	return a->when < b->when;
+    return a->seq < b->seq;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftUp
+// 	Move the interrupt at heap[i] up towards the root, until its
+//	parent fires before it.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftUp(int i)
+{
+    PendingInterrupt *item = heap[i];
+    int parent;
+
+    while (i > 0) {
+	parent = (i - 1) / 2;
+	if (!Before(item, heap[parent]))
+	    break;
+	heap[i] = heap[parent];
+	i = parent;
+    }
+    heap[i] = item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftDown
+// 	Move the interrupt at heap[i] down towards the leaves, until
+//	it fires before both of its children.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftDown(int i)
+{
+    PendingInterrupt *item = heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < numInQueue) {
+	if (child + 1 < numInQueue && Before(heap[child + 1], heap[child]))
+	    child++;			// pick the earlier of the children
+	if (!Before(heap[child], item))
+	    break;
+	heap[i] = heap[child];
+	i = child;
+    }
+    heap[i] = item;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+// 	Put an interrupt on the queue, growing the heap if it is full.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Insert(PendingInterrupt *toOccur)
+{
+    if (numInQueue == capacity) {
+	PendingInterrupt **bigger = new PendingInterrupt *[capacity * 2];
+
+	for (int i = 0; i < numInQueue; i++)
+	    bigger[i] = heap[i];
+	delete [] heap;
+	heap = bigger;
+	capacity *= 2;
+    }
+    toOccur->seq = nextSeq++;
+    heap[numInQueue] = toOccur;
+    SiftUp(numInQueue++);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Peek
+// 	Return the next interrupt to fire, without removing it.
+//	NULL if nothing is pending.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+PendingQueue::Peek()
+{
+    if (numInQueue == 0)
+	return NULL;
+    return heap[0];
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Remove
+// 	Remove the next interrupt to fire from the queue, and return it.
+//	NULL if nothing is pending.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+PendingQueue::Remove()
+{
+    PendingInterrupt *first;
+
+    if (numInQueue == 0)
+	return NULL;
+    first = heap[0];
+    heap[0] = heap[--numInQueue];
+    if (numInQueue > 0)
+	SiftDown(0);
+    return first;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Mapcar
+// 	Apply a function to each pending interrupt.  The heap is only
+//	partially ordered, so the interrupts are visited in no
+//	particular order.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < numInQueue; i++)
+	(*func)((int) heap[i]);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Reschedule
+// 	Change when the first interrupt of type "type" found on the
+//	queue is due, and move it to its new place in the heap.  Return
+//	FALSE if there is no interrupt of that type.
+//----------------------------------------------------------------------
+
+bool
+PendingQueue::Reschedule(IntType type, int when)
+{
+    for (int i = 0; i < numInQueue; i++)
+	if (heap[i]->type == type) {
+	    heap[i]->when = when;
+	    SiftUp(i);			// at most one of these moves it
+	    SiftDown(i);
+	    return TRUE;
+	}
+    return FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -60,10 +284,11 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new PendingQueue();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    interrupted = SystemMode;
 }
 
 //----------------------------------------------------------------------
@@ -74,7 +299,7 @@ Interrupt::Interrupt()
 Interrupt::~Interrupt()
 {
     while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
+	delete pending->Remove();
     delete pending;
 }
 
@@ -156,9 +381,11 @@ Interrupt::OneTick()
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
 	stats->systemTicks += SystemTick;
+	currentThread->AddUsage(ResSystemTicks, SystemTick);
     } else {					// USER_PROGRAM
 	stats->totalTicks += UserTick;
 	stats->userTicks += UserTick;
+	currentThread->AddUsage(ResUserTicks, UserTick);
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
@@ -167,6 +394,10 @@ Interrupt::OneTick()
 					// (interrupt handlers run with
 					// interrupts disabled)
     while (CheckIfDue(FALSE));		// check for pending interrupts
+#ifdef USER_PROGRAM
+    if (hostCPUs)			// and for CPUs handed back
+	CollectCPUs(FALSE);
+#endif
 	
     ChangeLevel(IntOff, IntOn);		// re-enable interrupts
     if (yieldOnReturn) {		// if the timer device handler asked 
@@ -206,12 +437,21 @@ Interrupt::YieldOnReturn()
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	While CPUs are running user code on their host threads, wait
+//	for one of them to stop instead: its thread will have more to do.
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IdleMode;
+#ifdef USER_PROGRAM
+    if (hostCPUs && CollectCPUs(TRUE)) {	// while CPUs run user code,
+	status = SystemMode;			// time is theirs to move on;
+	return;					// wait for one to come back
+    }
+#endif
     if (CheckIfDue(TRUE)) {		// check for any pending interrupts
     	while (CheckIfDue(FALSE))	// check for any other pending 
 	    ;				// interrupts
@@ -241,7 +481,45 @@ void
 Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
+    stats->RecordThread(currentThread->getName(), currentThread->getTid(),
+		currentThread->tickets, currentThread->CpuTicks());
+#ifdef USER_PROGRAM
+    for (int tid = 0; tid < threadTable->Size(); tid++) {
+	Thread *t = threadTable->Lookup(tid);	// processes still running
+
+	if (t != NULL && t->space != NULL)
+	    stats->RecordProcess(t->getName(), tid, &t->space->usage);
+    }
+#endif
+#ifdef USER_PROGRAM
+    if (hostCPUs)
+	StopCPUs();
+#endif
+    if (numCPUs > 1) {		// total time is when the last CPU is done
+	currentCPU->clock = stats->totalTicks;
+	for (int i = 0; i < numCPUs; i++)
+	    if (cpus[i]->clock > stats->totalTicks)
+		stats->totalTicks = cpus[i]->clock;
+    }
     stats->Print();
+    if (numCPUs > 1)
+	for (int i = 0; i < numCPUs; i++)
+	    cpus[i]->Print();
+    if (synchProfiler != NULL)
+	synchProfiler->Print();
+#ifdef USER_PROGRAM
+    for (int i = 0; i < numCPUs; i++) {
+	if (numCPUs > 1 && cpus[i]->machine->icache != NULL)
+	    printf("CPU %d:\n", i);
+	cpus[i]->machine->PrintCaches();
+    }
+    for (int tid = 0; tid < threadTable->Size(); tid++) {
+	Thread *t = threadTable->Lookup(tid);	// processes still running
+
+	if (t != NULL && t->space != NULL && t->space->profile != NULL)
+	    t->space->profile->Print(t->getName());
+    }
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -250,7 +528,7 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it on a heap ordered by "when".
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -271,7 +549,7 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur);
 }
 
 //----------------------------------------------------------------------
@@ -297,34 +575,38 @@ Interrupt::CheckIfDue(bool advanceClock)
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+    PendingInterrupt *toOccur = pending->Peek();	// leave it queued
+							// until it fires
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
+    when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
+	currentCPU->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {	// not time yet
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& (pending->NumInQueue() == 1))
 	 return FALSE;
-    }
+
+    (void) pending->Remove();		// it's toOccur; fire it
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
+    TRACE('i', TraceInterrupt, toOccur->type, stats->totalTicks - when, 0);
+    ReplayCheck(ReplayInterrupt, toOccur->type);
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
 #endif
     inHandler = TRUE;
+    interrupted = old;
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
@@ -350,6 +632,34 @@ PrintPending(int arg)
 	intTypeNames[pend->type], pend->when);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::MapPending
+// 	Apply a function to each interrupt that is scheduled to occur,
+//	in no particular order.  Used to checkpoint the machine.
+//
+//	"func" is called with a pointer to each PendingInterrupt.
+//----------------------------------------------------------------------
+
+void
+Interrupt::MapPending(VoidFunctionPtr func)
+{
+    pending->Mapcar(func);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Reschedule
+// 	Make the pending interrupt of type "type" due at time "when"
+//	instead.  Used to restore a checkpoint, so that the devices'
+//	polls fire when they would have in the saved run.  Return FALSE
+//	if no interrupt of that type is pending.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::Reschedule(IntType type, int when)
+{
+    return pending->Reschedule(type, when);
+}
+
 //----------------------------------------------------------------------
 // DumpState
 // 	Print the complete interrupt state - the status, and all interrupts
@@ -50,7 +50,8 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				ElevatorInt, NetworkSendInt, NetworkRecvInt};
+				ElevatorInt, NetworkSendInt, NetworkRecvInt,
+				SchedulerInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -62,11 +63,54 @@ class PendingInterrupt {
 				// initialize an interrupt that will
 				// occur in the future
 
+    void *operator new(size_t size);	// allocate from the free list,
+    void operator delete(void *p);	// and recycle onto it
+
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    int seq;			// order of scheduling, to break ties
+				// between interrupts due at the same time
+    PendingInterrupt *nextFree;	// link on the free list, once fired
+};
+
+// The following class defines the queue of pending interrupts -- a
+// binary min-heap ordered by "when", so that scheduling an interrupt
+// is O(log n), and looking at the next one to fire is O(1) and
+// does not remove it.  Interrupts due at the same time fire in the
+// order they were scheduled, as they did with a sorted list.
+
+class PendingQueue {
+  public:
+    PendingQueue();			// initialize an empty queue
+    ~PendingQueue();			// de-allocate the queue (but not
+					// the interrupts still on it)
+
+    void Insert(PendingInterrupt *toOccur);	// add an interrupt
+    PendingInterrupt *Peek();		// next interrupt to fire, left on
+					// the queue; NULL if queue is empty
+    PendingInterrupt *Remove();		// take the next interrupt to fire
+					// off the queue; NULL if empty
+
+    bool IsEmpty() { return numInQueue == 0; }
+    int NumInQueue() { return numInQueue; }
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every interrupt
+					// (in heap order, not firing order)
+    bool Reschedule(IntType type, int when);
+					// move an interrupt of this type to
+					// "when"; FALSE if there is none
+
+  private:
+    PendingInterrupt **heap;		// heap[0] is the next to fire
+    int numInQueue;			// # of interrupts on the queue
+    int capacity;			// size of "heap", doubled as needed
+    int nextSeq;			// sequence # of next Insert
+
+    bool Before(PendingInterrupt *a, PendingInterrupt *b);
+    void SiftUp(int i);			// restore the heap after an insert
+    void SiftDown(int i);		// restore the heap after a remove
 };
 
 // The following class defines the data structures for the simulation
@@ -97,8 +141,16 @@ class Interrupt {
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
+    MachineStatus getInterruptedStatus() { return interrupted; }
+					// what the CPU was doing when the
+					// handler being run was called
 
     void DumpState();			// Print interrupt state
+    void MapPending(VoidFunctionPtr func);	// Apply "func" to every
+					// pending interrupt, in no order
+    bool Reschedule(IntType type, int when);	// Make the pending
+					// interrupt of this type due at
+					// "when"; FALSE if there is none
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -114,12 +166,13 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
+    PendingQueue *pending;	// the interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
     MachineStatus status;	// idle, kernel mode, user mode
+    MachineStatus interrupted;	// status before the current handler
 
     // these functions are internal to the interrupt simulation code
 
@@ -44,9 +44,19 @@ void CheckEndian()
 #endif
 }
 
+// Shared by the Machines of all the CPUs
+char *Machine::mainMemory = NULL;
+BitMap *Machine::bitmap = NULL;
+char *Machine::swapspace = NULL;
+int Machine::swapoffset = 0;
+TranslationEntry *Machine::rPageTable = NULL;
+int Machine::numMachines = 0;
+
 //----------------------------------------------------------------------
 // Machine::Machine
-// 	Initialize the simulation of user program execution.
+// 	Initialize the simulation of user program execution.  The first
+//	Machine allocates main memory; the Machines of the other CPUs
+//	share it.
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
@@ -59,36 +69,38 @@ Machine::Machine(bool debug)
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
     
-    //初始化实存和虚存
-    mainMemory = new char[MemorySize];
-    swapspace = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++){
-        mainMemory[i] = i;
-        swapspace[i] = i;
-    }
-    //初始化bitmap,每一位控制一页
-    bitmap = new BitMap(NumPhysPages);
-    swapoffset = 0;
-    // fileSystem->Create("swapfile", MemorySize);
-    // swap = fileSystem->Open("swapfile");
-    // ASSERT(swap != NULL);
-    rPageTable = new TranslationEntry[NumPhysPages];
-    for(i = 0; i < NumPhysPages; i++){
-        rPageTable[i].physicalPage = i;
-        rPageTable[i].virtualPage = -1;
-        rPageTable[i].valid = FALSE;
-        rPageTable[i].readOnly = FALSE;
-        rPageTable[i].use = FALSE;
-        rPageTable[i].dirty = FALSE;
-        rPageTable[i].tid = -1;
+    if (numMachines++ == 0) {		// the first one: the shared memory
+        //初始化实存和虚存
+        mainMemory = new char[MemorySize];
+        swapspace = new char[MemorySize];
+        for (i = 0; i < MemorySize; i++){
+            mainMemory[i] = i;
+            swapspace[i] = i;
+        }
+        //初始化bitmap,每一位控制一页
+        bitmap = new BitMap(NumPhysPages);
+        swapoffset = 0;
+        // fileSystem->Create("swapfile", MemorySize);
+        // swap = fileSystem->Open("swapfile");
+        // ASSERT(swap != NULL);
+        rPageTable = new TranslationEntry[NumPhysPages];
+        for(i = 0; i < NumPhysPages; i++){
+            rPageTable[i].physicalPage = i;
+            rPageTable[i].virtualPage = -1;
+            rPageTable[i].valid = FALSE;
+            rPageTable[i].readOnly = FALSE;
+            rPageTable[i].use = FALSE;
+            rPageTable[i].dirty = FALSE;
+            rPageTable[i].tid = -1;
+        }
     }
 
-
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
+    for (i = 0; i < TLBSize; i++) {
         tlb[i].valid = FALSE;
         LRU_mark[i] = 0;
+    }
     pageTable = NULL;
 #else	// use linear page table
     tlb = NULL;
@@ -98,6 +110,12 @@ Machine::Machine(bool debug)
     //tlb hit miss
     tlb_hit = tlb_miss = 0;
 
+    icache = dcache = NULL;		// memory is flat until ConfigureCaches
+    missPenalty = 0;
+    onHost = FALSE;
+    hostTrap = NoException;
+    hostStall = 0;
+
     singleStep = debug;
     CheckEndian();
 }
@@ -119,11 +137,65 @@ Machine::~Machine()
     // }
     // float hitRate = (float)machine->tlb_hit/(machine->tlb_hit + machine->tlb_miss);
     // printf("tlb_hit: %d, tlb_miss: %d, hit_rate: %f\n", machine->tlb_hit,machine->tlb_miss,hitRate);
-    delete [] mainMemory;
-    delete [] swapspace;
-    delete [] rPageTable;
+    if (--numMachines == 0) {
+        delete [] mainMemory;
+        delete [] swapspace;
+        delete [] rPageTable;
+        delete bitmap;
+        mainMemory = swapspace = NULL;
+        rPageTable = NULL;
+        bitmap = NULL;
+    }
     if (tlb != NULL)
         delete [] tlb;
+    if (dcache != icache)
+        delete dcache;
+    delete icache;
+}
+
+//----------------------------------------------------------------------
+// Machine::ConfigureCaches
+// 	Put caches in front of main memory, as given by "-cache".
+//
+//	"spec" is "<size>,<assoc>,<line size>", in bytes, optionally
+//		followed by ",wt" for write-through caches (the default
+//		is write-back), and ",split" for an instruction cache and
+//		a data cache of that size each, instead of one for both.
+//	"penalty" is the number of ticks a miss stalls the CPU; with 0,
+//		the caches only count.
+//----------------------------------------------------------------------
+
+void
+Machine::ConfigureCaches(char *spec, int penalty)
+{
+    int size, assoc, lineSize;
+    bool writeBack = (strstr(spec, ",wt") == NULL);
+
+    if (sscanf(spec, "%d,%d,%d", &size, &assoc, &lineSize) != 3) {
+	printf("Bad cache \"%s\": want <size>,<assoc>,<line size>[,wt]"
+		"[,split]\n", spec);
+	ASSERT(FALSE);
+    }
+    if (strstr(spec, ",split") != NULL) {
+	icache = new Cache("I-cache", size, assoc, lineSize, writeBack);
+	dcache = new Cache("D-cache", size, assoc, lineSize, writeBack);
+    } else
+	icache = dcache = new Cache("Cache", size, assoc, lineSize, writeBack);
+    missPenalty = penalty;
+}
+
+//----------------------------------------------------------------------
+// Machine::PrintCaches
+// 	Print how well the caches did, if there are any.
+//----------------------------------------------------------------------
+
+void
+Machine::PrintCaches()
+{
+    if (icache != NULL)
+	icache->Print();
+    if (dcache != NULL && dcache != icache)
+	dcache->Print();
 }
 
 //----------------------------------------------------------------------
@@ -132,6 +204,9 @@ Machine::~Machine()
 //	the user program either invoked a system call, or some exception
 //	occured (such as the address translation failed).
 //
+//	On a CPU's host thread, only note the exception; RunOnHost stops,
+//	and the kernel handles it when it takes the CPU back.
+//
 //	"which" -- the cause of the kernel trap
 //	"badVaddr" -- the virtual address causing the trap, if appropriate
 //----------------------------------------------------------------------
@@ -144,11 +219,33 @@ Machine::RaiseException(ExceptionType which, int badVAddr)
 //  ASSERT(interrupt->getStatus() == UserMode);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
+    if (onHost) {			// the kernel isn't here; it takes
+	hostTrap = which;		// the trap once it gets the CPU back
+	return;
+    }
     interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     interrupt->setStatus(UserMode);
 }
 
+//----------------------------------------------------------------------
+// Machine::AddUsage
+// 	Charge the thread running user code for a resource it used.  On
+//	a CPU's host thread, where currentThread is whatever the kernel
+//	is running, keep count until the kernel takes the CPU back.
+//
+//	"r" is the resource, "n" how much of it.
+//----------------------------------------------------------------------
+
+void
+Machine::AddUsage(Resource r, int n)
+{
+    if (onHost)
+	hostUsage.count[r] += n;
+    else
+	currentThread->AddUsage(r, n);
+}
+
 //----------------------------------------------------------------------
 // Machine::Debugger
 // 	Primitive debugger for user programs.  Note that we can't use
@@ -12,6 +12,10 @@
 //	by the simulator.  Each memory reference is translated, checked
 //	for errors, etc.
 //
+//	On a multiprocessor there is one Machine per CPU, each with its
+//	own registers, TLB and caches; main memory, the swap space and
+//	the map of free frames are shared by all of them.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -26,6 +30,8 @@
 #include "translate.h"
 #include "disk.h"
 #include "bitmap.h"
+#include "cache.h"
+#include "stats.h"
 
 // Definitions related to the size, and format of user memory
 
@@ -72,6 +78,13 @@ enum ExceptionType { NoException,           // Everything ok!
 
 #define NumTotalRegs 	40
 
+// Who is accessing user memory: only the accesses of user instructions
+// go through the caches
+enum MemAccess { KernelAccess,		// the kernel, copying user data
+		 FetchAccess,		// an instruction fetch
+		 DataAccess		// a load or store
+};
+
 // The following class defines an instruction, represented in both
 // 	undecoded binary form
 //      decoded to identify
@@ -122,6 +135,10 @@ class Machine {
 	//PC向前
 	void PCAdvanced();
 
+    void ConfigureCaches(char *spec, int penalty);
+				// put caches in front of memory
+    void PrintCaches();		// print how well they did
+
 // Routines internal to the machine simulation -- DO NOT call these 
 
     void OneInstruction(Instruction *instr); 	
@@ -129,11 +146,16 @@ class Machine {
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
     
-    bool ReadMem(int addr, int size, int* value);
-    bool WriteMem(int addr, int size, int value);
+    bool ReadMem(int addr, int size, int* value,
+		 MemAccess access = KernelAccess);
+    bool WriteMem(int addr, int size, int value,
+		  MemAccess access = KernelAccess);
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+    void CacheAccess(int physAddr, MemAccess access, bool writing);
+				// run a user access through the caches,
+				// stalling the CPU on a miss
     
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
@@ -146,6 +168,12 @@ class Machine {
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
 
+    int RunOnHost(Instruction *instr, int ticks);
+				// Run instructions on a CPU's host thread,
+				// for up to "ticks", or until one raises
+				// an exception; return the time taken
+    void AddUsage(Resource r, int n);	// charge the running thread
+
     void Debugger();		// invoke the user program debugger
     void DumpState();		// print the user CPU and memory state 
 
@@ -156,15 +184,15 @@ class Machine {
 // Note that *all* communication between the user program and the kernel 
 // are in terms of these data structures.
 
-    char *mainMemory;		// physical memory to store user program,
+    static char *mainMemory;	// physical memory to store user program,
 				// code and data, while executing
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
 	//位图，全局内存管理
-	BitMap* bitmap;
+	static BitMap* bitmap;
 
-	char *swapspace;	//虚存
-	int swapoffset;	//虚存页偏移
+	static char *swapspace;	//虚存
+	static int swapoffset;	//虚存页偏移
 
 // NOTE: the hardware translation of virtual addresses in the user program
 // to physical addresses (relative to the beginning of "mainMemory")
@@ -190,15 +218,27 @@ class Machine {
     TranslationEntry *pageTable;
 	unsigned int pageTableSize;
 
-	TranslationEntry *rPageTable;
+	static TranslationEntry *rPageTable;
 	
 	int tlb_hit;	//tlb hit计数器
 	int tlb_miss;	//tlb_miss计数器
 	int LRU_mark[TLBSize];	//记录有多少次没有被用到了
 
+    Cache *icache;		// caches for instruction fetches and data,
+    Cache *dcache;		// the same one if unified; NULL if none
+    int missPenalty;		// ticks a cache miss stalls the CPU
+
+    // While a CPU's host thread runs us, the kernel is elsewhere; what
+    // the instructions need from it waits here until it takes over.
+    bool onHost;		// running on a CPU's host thread?
+    ExceptionType hostTrap;	// the exception that stopped us there
+    int hostStall;		// ticks stalled on cache misses there
+    ResourceUsage hostUsage;	// resources used there, not yet charged
+
 	
 
   private:
+    static int numMachines;	// Machines sharing mainMemory
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
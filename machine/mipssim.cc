@@ -25,25 +25,66 @@ static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	On a multiprocessor the thread may move to another CPU, so the
+//	instructions run on the Machine of the current CPU, which need
+//	not be this one.  When the CPUs have host threads, the current
+//	CPU runs a batch of instructions on its own (see cpu.h), and we
+//	take the exception it stopped on, if any.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
     Instruction *instr = new Instruction;  // storage for decoded instruction
+    ExceptionType trap;
 
     if(DebugIsEnabled('m'))
         printf("Starting thread \"%s\" at time %d\n",
 	       currentThread->getName(), stats->totalTicks);
     interrupt->setStatus(UserMode);
     for (;;) {
-		OneInstruction(instr);
+		if (!hostCPUs)
+			machine->OneInstruction(instr);
+		else if ((trap = currentCPU->RunUser()) != NoException)
+			machine->RaiseException(trap,
+					machine->ReadRegister(BadVAddrReg));
 		interrupt->OneTick();
-		if (singleStep && (runUntilTime <= stats->totalTicks))
-			Debugger();
+		if (machine->singleStep
+				&& (machine->runUntilTime <= stats->totalTicks))
+			machine->Debugger();
 	}
 }
 
+//----------------------------------------------------------------------
+// Machine::RunOnHost
+// 	Run user instructions on the host thread of this Machine's CPU,
+//	while the kernel gets on with other things, until "ticks" of
+//	time have passed or an instruction raises an exception.  The
+//	time the instructions take is only returned, and what they use
+//	only noted (see AddUsage); the kernel takes the exception, and
+//	catches up, when it has the CPU back.
+//
+//	"instr" -- storage for the decoded instruction
+//	"ticks" -- how long to run; the instructions take at least one
+//----------------------------------------------------------------------
+
+int
+Machine::RunOnHost(Instruction *instr, int ticks)
+{
+    int ran = 0;
+
+    onHost = TRUE;
+    hostTrap = NoException;
+    hostStall = 0;
+    do {
+	OneInstruction(instr);
+	ran += UserTick;
+    } while (ran < ticks && hostTrap == NoException);
+    onHost = FALSE;
+    return ran + hostStall;
+}
+
 
 //----------------------------------------------------------------------
 // TypeToReg
@@ -99,7 +140,7 @@ Machine::OneInstruction(Instruction *instr)
 				// in the future
 
     // Fetch instruction 
-    if (!machine->ReadMem(registers[PCReg], 4, &raw))
+    if (!ReadMem(registers[PCReg], 4, &raw, FetchAccess))
 	return;			// exception occurred
     instr->value = raw;
     instr->Decode();
@@ -231,7 +272,7 @@ Machine::OneInstruction(Instruction *instr)
       case OP_LB:
       case OP_LBU:
 	tmp = registers[instr->rs] + instr->extra;
-	if (!machine->ReadMem(tmp, 1, &value))
+	if (!ReadMem(tmp, 1, &value, DataAccess))
 	    return;
 
 	if ((value & 0x80) && (instr->opCode == OP_LB))
@@ -249,7 +290,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 2, &value))
+	if (!ReadMem(tmp, 2, &value, DataAccess))
 	    return;
 
 	if ((value & 0x8000) && (instr->opCode == OP_LH))
@@ -271,7 +312,7 @@ Machine::OneInstruction(Instruction *instr)
 	    RaiseException(AddressErrorException, tmp);
 	    return;
 	}
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value, DataAccess))
 	    return;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
@@ -285,7 +326,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value, DataAccess))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -316,7 +357,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem(tmp, 4, &value))
+	if (!ReadMem(tmp, 4, &value, DataAccess))
 	    return;
 	if (registers[LoadReg] == instr->rt)
 	    nextLoadValue = registers[LoadValueReg];
@@ -381,14 +422,16 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SB:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
+	if (!WriteMem((unsigned) 
+		(registers[instr->rs] + instr->extra), 1, registers[instr->rt],
+		DataAccess))
 	    return;
 	break;
 	
       case OP_SH:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
+	if (!WriteMem((unsigned) 
+		(registers[instr->rs] + instr->extra), 2, registers[instr->rt],
+		DataAccess))
 	    return;
 	break;
 	
@@ -469,8 +512,9 @@ Machine::OneInstruction(Instruction *instr)
 	break;
 	
       case OP_SW:
-	if (!machine->WriteMem((unsigned) 
-		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
+	if (!WriteMem((unsigned) 
+		(registers[instr->rs] + instr->extra), 4, registers[instr->rt],
+		DataAccess))
 	    return;
 	break;
 	
@@ -481,7 +525,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value, DataAccess))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -500,7 +544,7 @@ Machine::OneInstruction(Instruction *instr)
 					    0xff);
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value, DataAccess))
 	    return;
 	break;
     	
@@ -511,7 +555,7 @@ Machine::OneInstruction(Instruction *instr)
         // fail (I think) if the other cases are ever exercised.
 	ASSERT((tmp & 0x3) == 0);  
 
-	if (!machine->ReadMem((tmp & ~0x3), 4, &value))
+	if (!ReadMem((tmp & ~0x3), 4, &value, DataAccess))
 	    return;
 	switch (tmp & 0x3) {
 	  case 0:
@@ -527,7 +571,7 @@ Machine::OneInstruction(Instruction *instr)
 	    value = registers[instr->rt];
 	    break;
 	}
-	if (!machine->WriteMem((tmp & ~0x3), 4, value))
+	if (!WriteMem((tmp & ~0x3), 4, value, DataAccess))
 	    return;
 	break;
     	
@@ -10,6 +10,7 @@
 
 #include "copyright.h"
 #include "system.h"
+#include "replay.h"
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
@@ -65,18 +66,20 @@ Network::CheckPktAvail()
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    // do nothing if no packet to be read; when replaying, the log
+    // says whether one arrived, and what it was
+    char buffer[MaxWireSize];
+    bool avail = (replayMode != ReplayReplaying) && PollSocket(sock);
+    if (avail)
+	ReadFromSocket(sock, buffer, MaxWireSize);
+    if (!ReplayInput(ReplayPacket, buffer, MaxWireSize, avail))
+	return;
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
     ASSERT((inHdr.to == ident) && (inHdr.length <= MaxPacketSize));
     bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete []buffer ;
 
     DEBUG('n', "Network received packet from %d, length %d...\n",
 	  				(int) inHdr.from, inHdr.length);
@@ -0,0 +1,320 @@
+// replay.cc
+//	Routines to record the non-deterministic inputs of a run into a
+//	log, and to feed them back in from it.  See replay.h for what is
+//	logged, and how the log is laid out.
+//
+//	When replaying, each kind of event is taken from the log in the
+//	order it was recorded, independently of the others: a Random()
+//	call gets the next logged Random() result, whatever else was
+//	logged around it.  So a kernel that, say, polls the console once
+//	more than the recorded one still draws the same random numbers;
+//	the difference is reported, but the replay goes on.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "replay.h"
+#include "system.h"
+
+ReplayMode replayMode = ReplayOff;
+
+static char *replayName;		// the log file
+
+// Recording
+static int replayFile;			// the log, open for writing
+static ReplayRecord *replayBuffer;	// records not yet written
+static int replayBuffered;		// ... how many
+static int replayTotal;			// records ever made
+
+// Replaying
+static char *replayImage;		// the log, mapped into memory
+static int replayImageSize;
+static ReplayRecord *replayLog;		// the records in it
+static int replayLength;		// ... how many
+static int replayCursor[NumReplayEvents];	// where to look for the
+						// next event of each kind
+static int replayUsed;			// records replayed
+static bool replayDiverged;		// has a difference been reported?
+static bool replayExhausted;		// has the log run out?
+
+// Indexed by ReplayEventType
+static char *replayEventNames[NumReplayEvents] = {
+    "random", "interrupt", "console", "packet", "data"
+};
+
+//----------------------------------------------------------------------
+// ReplayTime
+// 	The simulated time to stamp on a record.  Random() may be called
+//	before the statistics exist.
+//----------------------------------------------------------------------
+
+static int
+ReplayTime()
+{
+    return (stats != NULL) ? stats->totalTicks : 0;
+}
+
+//----------------------------------------------------------------------
+// ReplayFlush
+// 	Write the buffered records out to the log.
+//----------------------------------------------------------------------
+
+static void
+ReplayFlush()
+{
+    WriteFile(replayFile, (char *) replayBuffer,
+	      replayBuffered * sizeof(ReplayRecord));
+    replayBuffered = 0;
+}
+
+//----------------------------------------------------------------------
+// ReplayAppend
+// 	Add a record to the log.
+//
+//	"event" is the ReplayEventType.
+//	"value" is what happened.
+//----------------------------------------------------------------------
+
+static void
+ReplayAppend(ReplayEventType event, int value)
+{
+    ReplayRecord *rec = &replayBuffer[replayBuffered];
+
+    rec->time = ReplayTime();
+    rec->event = event;
+    rec->pad = 0;
+    rec->value = value;
+    replayTotal++;
+    if (++replayBuffered == ReplayBufferSize)
+	ReplayFlush();
+}
+
+//----------------------------------------------------------------------
+// ReplayDiverge
+// 	Report that the run has stopped following the log, the first
+//	time it happens.
+//
+//	"rec" is the logged record.
+//	"value" is what happened this time instead.
+//----------------------------------------------------------------------
+
+static void
+ReplayDiverge(ReplayRecord *rec, int value)
+{
+    if (replayDiverged)
+	return;
+    replayDiverged = TRUE;
+    printf("Replay diverges at tick %d: %s %d, logged at tick %d as %d\n",
+	ReplayTime(), replayEventNames[rec->event], value, rec->time,
+	rec->value);
+}
+
+//----------------------------------------------------------------------
+// ReplayNext
+// 	Find the next logged record of one kind, and check that it is
+//	being replayed at the time it was recorded.  Return NULL if the
+//	log has no more of them.
+//
+//	"event" is the ReplayEventType.
+//	"value" is what happened this time, for the report if the time
+//		is wrong.
+//----------------------------------------------------------------------
+
+static ReplayRecord *
+ReplayNext(ReplayEventType event, int value)
+{
+    int i = replayCursor[event];
+    ReplayRecord *rec;
+
+    while (i < replayLength && replayLog[i].event != event)
+	i++;
+    replayCursor[event] = i;
+    if (i == replayLength) {
+	if (!replayExhausted) {
+	    replayExhausted = TRUE;
+	    printf("Replay: the log has no more %s events, at tick %d\n",
+		replayEventNames[event], ReplayTime());
+	}
+	return NULL;
+    }
+    rec = &replayLog[i];
+    replayCursor[event] = i + 1;
+    replayUsed++;
+    if (rec->time != ReplayTime())
+	ReplayDiverge(rec, value);
+    return rec;
+}
+
+//----------------------------------------------------------------------
+// ReplayInit
+// 	Start recording a new log, or replaying an old one.  If the log
+//	can't be replayed, the run goes on without it.
+//
+//	"fileName" is the UNIX file holding the log.
+//	"mode" is ReplayRecording or ReplayReplaying.
+//----------------------------------------------------------------------
+
+void
+ReplayInit(char *fileName, ReplayMode mode)
+{
+    ReplayHeader hdr;
+    ReplayHeader *logHdr;
+
+    replayName = fileName;
+    if (mode == ReplayRecording) {
+	replayFile = OpenForWrite(fileName);
+	hdr.magic = ReplayMagic;
+	hdr.version = ReplayVersion;
+	WriteFile(replayFile, (char *) &hdr, sizeof(hdr));
+	replayBuffer = new ReplayRecord[ReplayBufferSize];
+	replayBuffered = replayTotal = 0;
+	replayMode = ReplayRecording;
+	return;
+    }
+
+    ASSERT(mode == ReplayReplaying);
+    replayImage = MapFile(fileName, &replayImageSize);
+    if (replayImage == NULL) {
+	printf("Unable to replay %s\n", fileName);
+	return;
+    }
+    logHdr = (ReplayHeader *) replayImage;
+    if (replayImageSize < (int) sizeof(ReplayHeader)
+		|| logHdr->magic != ReplayMagic
+		|| logHdr->version != ReplayVersion
+		|| (replayImageSize - sizeof(ReplayHeader))
+			% sizeof(ReplayRecord) != 0) {
+	printf("Unable to replay %s: not a replay log\n", fileName);
+	UnmapFile(replayImage, replayImageSize);
+	return;
+    }
+    replayLog = (ReplayRecord *) (replayImage + sizeof(ReplayHeader));
+    replayLength = (replayImageSize - sizeof(ReplayHeader))
+			/ sizeof(ReplayRecord);
+    for (int i = 0; i < NumReplayEvents; i++)
+	replayCursor[i] = 0;
+    replayUsed = 0;
+    replayDiverged = replayExhausted = FALSE;
+    replayMode = ReplayReplaying;
+}
+
+//----------------------------------------------------------------------
+// ReplayEnd
+// 	Finish with the log: write out the rest of it, or say how much
+//	of it was replayed, and whether the run followed it.
+//----------------------------------------------------------------------
+
+void
+ReplayEnd()
+{
+    if (replayMode == ReplayRecording) {
+	ReplayFlush();
+	Close(replayFile);
+	delete [] replayBuffer;
+	printf("Replay: recorded %d events in %s\n", replayTotal, replayName);
+    } else if (replayMode == ReplayReplaying) {
+	printf("Replay: replayed %d of %d events from %s, %s\n", replayUsed,
+	    replayLength, replayName,
+	    replayDiverged ? "diverged" : "no divergence");
+	UnmapFile(replayImage, replayImageSize);
+    }
+    replayMode = ReplayOff;
+}
+
+//----------------------------------------------------------------------
+// ReplayValue
+// 	Record a value the simulation computed, or replace it with the
+//	value recorded in its place.  If the log has run out, the value
+//	computed this time is used.
+//
+//	"event" is the ReplayEventType.
+//	"value" is the value computed this time.
+//----------------------------------------------------------------------
+
+int
+ReplayValue(ReplayEventType event, int value)
+{
+    ReplayRecord *rec;
+
+    if (replayMode == ReplayRecording) {
+	ReplayAppend(event, value);
+    } else if (replayMode == ReplayReplaying) {
+	rec = ReplayNext(event, value);
+	if (rec != NULL)
+	    return rec->value;
+    }
+    return value;
+}
+
+//----------------------------------------------------------------------
+// ReplayCheck
+// 	Record an event that doesn't depend on the host, such as an
+//	interrupt firing, or check that it is the one recorded in its
+//	place.
+//
+//	"event" is the ReplayEventType.
+//	"value" is what happened this time.
+//----------------------------------------------------------------------
+
+void
+ReplayCheck(ReplayEventType event, int value)
+{
+    ReplayRecord *rec;
+
+    if (replayMode == ReplayRecording) {
+	ReplayAppend(event, value);
+    } else if (replayMode == ReplayReplaying) {
+	rec = ReplayNext(event, value);
+	if (rec != NULL && rec->value != value)
+	    ReplayDiverge(rec, value);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReplayInput
+// 	Record the result of polling a device, or replace it with the
+//	recorded one.  Returns TRUE if there is input in "buffer".
+//
+//	When replaying, the device must not have polled the host, since
+//	the input it would have found is not the one that was recorded.
+//	Once the log has run out, no more input arrives.
+//
+//	"event" is the ReplayEventType: ReplayConsole or ReplayPacket.
+//	"buffer" holds the input that arrived, or gets the recorded one.
+//	"size" is the number of bytes of input.
+//	"available" is TRUE if input arrived this time.
+//----------------------------------------------------------------------
+
+bool
+ReplayInput(ReplayEventType event, char *buffer, int size, bool available)
+{
+    ReplayRecord *rec;
+    int i, n, word;
+
+    if (replayMode == ReplayRecording) {
+	ReplayAppend(event, available ? size : -1);
+	for (i = 0; available && i < size; i += sizeof(int)) {
+	    n = min(size - i, (int) sizeof(int));
+	    word = 0;
+	    bcopy(buffer + i, (char *) &word, n);
+	    ReplayAppend(ReplayData, word);
+	}
+    } else if (replayMode == ReplayReplaying) {
+	rec = ReplayNext(event, available ? size : -1);
+	if (rec == NULL || rec->value < 0)
+	    return FALSE;
+	ASSERT(rec->value == size);
+	for (i = 0; i < size; i += sizeof(int)) {	// the data follows
+	    rec++;
+	    ASSERT(rec < replayLog + replayLength
+		   && rec->event == ReplayData);
+	    n = min(size - i, (int) sizeof(int));
+	    bcopy((char *) &rec->value, buffer + i, n);
+	    replayUsed++;
+	}
+	return TRUE;
+    }
+    return available;
+}
@@ -0,0 +1,84 @@
+// replay.h
+//	Data structures to record the non-deterministic inputs of a run
+//	of Nachos, and to play them back.
+//
+//	Simulated time is deterministic, but what feeds it is not: the
+//	pseudo-random numbers (random time slices, lost packets, lottery
+//	draws), and whether a character has been typed or a packet has
+//	arrived when the console or the network polls the host.
+//
+//	"-rec <file>" logs each of these, as it happens, along with every
+//	interrupt that fires.  "-rep <file>" takes the inputs from the
+//	log instead, in the order they were recorded: the console and
+//	the network don't look at the host at all.  So a replayed run
+//	sees the same inputs as the recorded one, and -- for the same
+//	kernel -- makes the same schedule.
+//
+//	A replay also compares the interrupts that fire, and the times
+//	the inputs are asked for, with the log, and reports the first
+//	place they differ.  Replaying one log against two versions of the
+//	kernel shows where their schedules part.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define ReplayMagic		0x4e52504c	// "NRPL"
+#define ReplayVersion		1
+#define ReplayBufferSize	4096		// records written at a time
+
+enum ReplayMode { ReplayOff, ReplayRecording, ReplayReplaying };
+
+// What is logged
+enum ReplayEventType {
+    ReplayRandom,		// a Random() result
+    ReplayInterrupt,		// an interrupt fired; value is its IntType
+    ReplayConsole,		// a console poll; value is -1 if nothing
+				// was typed, else 1 and one data record
+    ReplayPacket,		// a network poll; value is -1 if nothing
+				// arrived, else the size of the packet,
+				// in the data records that follow
+    ReplayData,			// four bytes of input
+    NumReplayEvents
+};
+
+// One record of the log
+typedef struct replayRecord {
+    int time;			// stats->totalTicks
+    short event;		// ReplayEventType
+    short pad;
+    int value;
+} ReplayRecord;
+
+// The log is this header, followed by the records in the order they
+// were made.
+typedef struct replayHeader {
+    int magic;			// should be ReplayMagic
+    int version;		// should be ReplayVersion
+} ReplayHeader;
+
+extern ReplayMode replayMode;
+
+extern void ReplayInit(char *fileName, ReplayMode mode);
+				// start recording to, or replaying from,
+				// the log "fileName"
+extern void ReplayEnd();	// write out the log, or report how the
+				// replay went
+
+extern int ReplayValue(ReplayEventType event, int value);
+				// log "value", or return the logged one
+extern bool ReplayInput(ReplayEventType event, char *buffer, int size,
+			bool available);
+				// log an input of "size" bytes, or copy
+				// the logged one into "buffer"
+extern void ReplayCheck(ReplayEventType event, int value);
+				// log "value", or compare it with the
+				// logged one
+
+#endif // REPLAY_H
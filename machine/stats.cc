@@ -22,6 +22,77 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numListElementAllocs = numListElementReuses = 0;
+    numPendingAllocs = numPendingReuses = 0;
+    numStackAllocs = numStackReuses = 0;
+    reportShares = FALSE;
+    numJobs = numDeadlineMisses = numThrottles = 0;
+    numSteals = numMigrations = 0;
+    runQueueSamples = runQueueTotal = runQueueMax = 0;
+    cacheStallTicks = 0;
+    numThreadRecords = numThreadsDropped = 0;
+    numProcessRecords = numProcessesDropped = 0;
+}
+
+//----------------------------------------------------------------------
+// ResourceUsage::ResourceUsage
+// 	Initialize the resource counters of a thread or address space
+//	to zero.
+//----------------------------------------------------------------------
+
+ResourceUsage::ResourceUsage()
+{
+    for (int i = 0; i < NumResources; i++)
+	count[i] = 0;
+}
+
+//----------------------------------------------------------------------
+// Statistics::RecordThread
+// 	Remember the CPU time a thread got, so that Print can report
+//	the share each thread achieved.  Called as threads go away.
+//----------------------------------------------------------------------
+
+void
+Statistics::RecordThread(char *name, int tid, int tickets, int cpuTicks)
+{
+    ThreadRecord *rec;
+
+    if (numThreadRecords == MaxThreadRecords) {
+	numThreadsDropped++;
+	return;
+    }
+    rec = &threadRecords[numThreadRecords++];
+    strncpy(rec->name, name, sizeof(rec->name) - 1);
+    rec->name[sizeof(rec->name) - 1] = '\0';
+    rec->tid = tid;
+    rec->tickets = tickets;
+    rec->cpuTicks = cpuTicks;
+}
+
+//----------------------------------------------------------------------
+// Statistics::RecordProcess
+// 	Remember the resources a user process used, so that Print can
+//	report them.  Called as address spaces go away, and at the end
+//	for those that are still around.
+//
+//	"name", "tid" identify the thread running in the address space.
+//	"usage" is what the address space used.
+//----------------------------------------------------------------------
+
+void
+Statistics::RecordProcess(char *name, int tid, ResourceUsage *usage)
+{
+    ProcessRecord *rec;
+
+    if (numProcessRecords == MaxProcessRecords) {
+	numProcessesDropped++;
+	return;
+    }
+    rec = &processRecords[numProcessRecords++];
+    strncpy(rec->name, name, sizeof(rec->name) - 1);
+    rec->name[sizeof(rec->name) - 1] = '\0';
+    rec->tid = tid;
+    rec->usage = *usage;
 }
 
 //----------------------------------------------------------------------
@@ -41,4 +112,78 @@ Statistics::Print()
     printf("Paging: faults %d\n", numPageFaults);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    printf("Allocation: list elements %d (reused %d), "
+	"pending interrupts %d (reused %d)\n", numListElementAllocs,
+	numListElementReuses, numPendingAllocs, numPendingReuses);
+    printf("Thread stacks: allocated %d, reused %d\n", numStackAllocs,
+	numStackReuses);
+    if (numJobs > 0 || numThrottles > 0)
+	printf("Real-time: jobs %d, deadline misses %d, throttled %d\n",
+	    numJobs, numDeadlineMisses, numThrottles);
+    if (runQueueSamples > 0)
+	printf("Run queues: steals %d, migrations %d, average length %d.%02d, "
+	    "longest %d\n", numSteals, numMigrations,
+	    runQueueTotal / runQueueSamples,
+	    (runQueueTotal % runQueueSamples) * 100 / runQueueSamples, runQueueMax);
+
+    if (reportShares && numThreadRecords > 0) {
+	int ticks = 0, tickets = 0, i;
+
+	for (i = 0; i < numThreadRecords; i++) {
+	    ticks += threadRecords[i].cpuTicks;
+	    tickets += threadRecords[i].tickets;
+	}
+	printf("CPU shares (thread, tid, tickets, ticks, share of ticks, "
+		"share of tickets):\n");
+	for (i = 0; i < numThreadRecords; i++)
+	    printf("  %-15s %3d %6d %8d %4d%% %4d%%\n", threadRecords[i].name,
+		threadRecords[i].tid, threadRecords[i].tickets,
+		threadRecords[i].cpuTicks,
+		(ticks > 0) ? threadRecords[i].cpuTicks * 100 / ticks : 0,
+		threadRecords[i].tickets * 100 / tickets);
+	if (numThreadsDropped > 0)
+	    printf("  (%d more threads not recorded)\n", numThreadsDropped);
+    }
+
+    if (numProcessRecords > 0) {
+	printf("Processes (thread, tid, ticks: user, system, waiting; page "
+		"faults, TLB misses, disk reads, writes, syscalls, "
+		"switches):\n");
+	for (int i = 0; i < numProcessRecords; i++) {
+	    int *count = processRecords[i].usage.count;
+
+	    printf("  %-15s %5d %8d %8d %8d %6d %6d %6d %6d %6d %6d\n",
+		processRecords[i].name, processRecords[i].tid,
+		count[ResUserTicks], count[ResSystemTicks],
+		count[ResWaitTicks], count[ResPageFaults],
+		count[ResTLBMisses], count[ResDiskReads],
+		count[ResDiskWrites], count[ResSyscalls],
+		count[ResContextSwitches]);
+	}
+	if (numProcessesDropped > 0)
+	    printf("  (%d more processes not recorded)\n",
+		numProcessesDropped);
+    }
+
+    bool header = FALSE;
+
+    if (cacheStallTicks > 0)
+	printf("Cache stalls: %d of %d user ticks\n", cacheStallTicks,
+	    userTicks);
+    for (int i = 0; i < numProcessRecords; i++) {
+	int *count = processRecords[i].usage.count;
+
+	if (count[ResCacheAccesses] == 0)
+	    continue;
+	if (!header) {
+	    printf("Process caching (thread, tid, accesses, misses, "
+		"hit rate):\n");
+	    header = TRUE;
+	}
+	printf("  %-15s %5d %10d %8d %6.2f%%\n", processRecords[i].name,
+	    processRecords[i].tid, count[ResCacheAccesses],
+	    count[ResCacheMisses],
+	    (count[ResCacheAccesses] - count[ResCacheMisses]) * 100.0
+						/ count[ResCacheAccesses]);
+    }
 }
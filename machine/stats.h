@@ -13,6 +13,51 @@
 
 #include "copyright.h"
 
+// What we remember about each thread, for reporting CPU shares
+#define MaxThreadRecords 64
+
+typedef struct threadRecord {
+    char name[16];		// thread name, truncated
+    int tid;
+    int tickets;		// its own tickets
+    int cpuTicks;		// CPU time it used
+} ThreadRecord;
+
+// The resources used by one thread, or by one address space.  The
+// order is also that of the counters returned by the GetStats system
+// call (see userprog/syscall.h), so only add to the end.
+
+enum Resource {
+    ResUserTicks,		// time running user code
+    ResSystemTicks,		// time running in the kernel
+    ResWaitTicks,		// time ready, but waiting for the CPU
+    ResPageFaults,		// pages brought into memory
+    ResTLBMisses,		// TLB misses
+    ResDiskReads,		// disk sectors read
+    ResDiskWrites,		// disk sectors written
+    ResSyscalls,		// system calls made
+    ResContextSwitches,		// times given the CPU
+    ResCacheAccesses,		// memory accesses through the caches
+    ResCacheMisses,		// ... that missed
+    NumResources
+};
+
+class ResourceUsage {
+  public:
+    ResourceUsage();		// all zero
+
+    int count[NumResources];	// indexed by Resource
+};
+
+// What we remember about each process, for the end-of-run table
+#define MaxProcessRecords 64
+
+typedef struct processRecord {
+    char name[16];		// name of its (first) thread, truncated
+    int tid;
+    ResourceUsage usage;
+} ProcessRecord;
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -36,9 +81,44 @@ class Statistics {
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
 
+    int numListElementAllocs;	// list elements taken from the heap
+    int numListElementReuses;	// list elements recycled from the free list
+    int numPendingAllocs;	// pending interrupts taken from the heap
+    int numPendingReuses;	// pending interrupts recycled
+    int numStackAllocs;		// thread stacks newly mapped
+    int numStackReuses;		// thread stacks recycled
+
+    bool reportShares;		// print the CPU share of each thread?
+
+    int numJobs;		// periodic jobs completed
+    int numDeadlineMisses;	// ... of which, completed after the deadline
+    int numThrottles;		// periodic threads stopped for overrunning
+
+    int numSteals;		// threads taken by an idle processor from
+				// another processor's run queue
+    int numMigrations;		// threads moved to another processor
+    int runQueueSamples;	// run queue lengths looked at
+    int runQueueTotal;		// ... their sum
+    int runQueueMax;		// ... and the longest one
+
+    int cacheStallTicks;	// user time spent on cache misses
+
     Statistics(); 		// initialize everything to zero
 
     void Print();		// print collected statistics
+
+    void RecordThread(char *name, int tid, int tickets, int cpuTicks);
+				// remember how much CPU a thread got
+    void RecordProcess(char *name, int tid, ResourceUsage *usage);
+				// remember what a process used
+
+  private:
+    ThreadRecord threadRecords[MaxThreadRecords];
+    int numThreadRecords;	// records kept
+    int numThreadsDropped;	// records that didn't fit
+    ProcessRecord processRecords[MaxProcessRecords];
+    int numProcessRecords;
+    int numProcessesDropped;
 };
 
 // Constants used to reflect the relative time an operation would
@@ -35,6 +35,9 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
 #ifdef HOST_i386
 #include <unistd.h>
 #include <sys/time.h>
@@ -99,6 +102,7 @@ void exit(int);
 
 #include "interrupt.h"
 #include "system.h"
+#include "replay.h"
 
 //----------------------------------------------------------------------
 // PollFile
@@ -146,17 +150,18 @@ PollFile(int fd)
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it 
-//	if it does already exist.  Return the file descriptor.
+//	if it does already exist.  Return the file descriptor, or -1 if
+//	it can't be opened and "crashOnError" is FALSE.
 //
 //	"name" -- file name
 //----------------------------------------------------------------------
 
 int
-OpenForWrite(char *name)
+OpenForWrite(char *name, bool crashOnError)
 {
     int fd = open(name, O_RDWR|O_CREAT|O_TRUNC, 0666);
 
-    ASSERT(fd >= 0); 
+    ASSERT(!crashOnError || fd >= 0); 
     return fd;
 }
 
@@ -214,6 +219,18 @@ WriteFile(int fd, char *buffer, int nBytes)
     ASSERT(retVal == nBytes);
 }
 
+//----------------------------------------------------------------------
+// WritePartial
+// 	Write characters to an open file, returning how many were
+//	written, or -1 on error.
+//----------------------------------------------------------------------
+
+int
+WritePartial(int fd, char *buffer, int nBytes)
+{
+    return write(fd, buffer, nBytes);
+}
+
 //----------------------------------------------------------------------
 // Lseek
 // 	Change the location within an open file.  Abort on error.
@@ -265,6 +282,48 @@ Unlink(char *name)
     return unlink(name);
 }
 
+//----------------------------------------------------------------------
+// MapFile
+// 	Map an entire file read-only into our address space, so that
+//	large images (e.g., checkpoints) can be loaded without copying
+//	them through read().  Return NULL if the file can't be mapped.
+//
+//	"name" -- file name
+//	"size" -- set to the number of bytes mapped
+//----------------------------------------------------------------------
+
+char *
+MapFile(char *name, int *size)
+{
+    struct stat st;
+    void *addr;
+    int fd = open(name, O_RDONLY, 0);
+
+    if (fd < 0)
+	return NULL;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+	close(fd);
+	return NULL;
+    }
+    addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);			// the mapping stays valid after close
+    if (addr == MAP_FAILED)
+	return NULL;
+    *size = st.st_size;
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo a MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int size)
+{
+    (void) munmap(addr, size);
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 // 	Open an interprocess communication (IPC) connection.  For now, 
@@ -452,13 +511,14 @@ RandomInit(unsigned seed)
 
 //----------------------------------------------------------------------
 // Random
-// 	Return a pseudo-random number.
+// 	Return a pseudo-random number, or, when replaying, the one
+//	that was returned here in the recorded run.
 //----------------------------------------------------------------------
 
 int 
 Random()
 {
-    return rand();
+    return ReplayValue(ReplayRandom, rand());
 }
 
 //----------------------------------------------------------------------
@@ -470,17 +530,31 @@ Random()
 //
 //	Note: Just return the useful part!
 //
-//	"size" -- amount of useful space needed (in bytes)
+//	The array is mapped directly, rather than taken from the heap, so
+//	that the boundary pages are page-aligned and can be protected.
+//	This is a couple of system calls per array, and three host
+//	mappings; callers that need many arrays of one size (thread
+//	stacks) should take them from ReserveBoundedArrays instead.
+//	Returns NULL if the host has run out of memory or mappings.
+//
+//	"size" -- amount of useful space needed (in bytes); rounded up
+//		to a whole number of pages, so the array ends some way
+//		short of the upper boundary page on hosts with big pages
 //----------------------------------------------------------------------
 
 char * 
 AllocBoundedArray(int size)
 {
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
-
-    //mprotect(ptr, pgSize, 0);
-    //mprotect(ptr + pgSize + size, pgSize, 0);
+    char *ptr;
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    ptr = (char *) mmap(NULL, pgSize * 2 + size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (ptr == (char *) MAP_FAILED)
+	return NULL;
+    mprotect(ptr, pgSize, PROT_NONE);
+    mprotect(ptr + pgSize + size, pgSize, PROT_NONE);
     return ptr + pgSize;
 }
 
@@ -497,7 +571,174 @@ DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    size = divRoundUp(size, pgSize) * pgSize;	// as AllocBoundedArray did
+    munmap(ptr - pgSize, pgSize * 2 + size);
+}
+
+//----------------------------------------------------------------------
+// ReserveBoundedArrays
+// 	Reserve host address space for "count" bounded arrays of the same
+//	size, to be handed out in order by CommitBoundedArray.  They are
+//	laid out one after another, with a page between each and the
+//	next, and before the first and after the last, that is never
+//	made accessible.  Returns NULL if the host hasn't that much
+//	address space to spare.
+//
+//	The host allows only so many mappings per process (about 65530
+//	on Linux), and a guarded array splits off two of them; so when
+//	they run out, CommitBoundedArray gives up guard pages, rather
+//	than arrays.
+//
+//	"size" -- amount of useful space in each array (in bytes)
+//	"count" -- how many arrays
+//----------------------------------------------------------------------
+
+char *
+ReserveBoundedArrays(int size, int count)
+{
+    int pgSize = getpagesize();
+    char *ptr;
+
+    size = divRoundUp(size, pgSize) * pgSize;	// as AllocBoundedArray does
+    if (count > (0x7fffffff - pgSize) / (pgSize + size))
+	return NULL;
+    ptr = (char *) mmap(NULL, (pgSize + size) * count + pgSize, PROT_NONE,
+			MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+    if (ptr == (char *) MAP_FAILED)
+	return NULL;
+    return ptr;
+}
+
+//----------------------------------------------------------------------
+// CommitBoundedArray
+// 	Make one of the arrays reserved by ReserveBoundedArrays usable,
+//	and return it; or return NULL if the host has run out of memory.
+//	The arrays must be committed in order, 0 first.
+//
+//	If the host has run out of mappings, the guard page below the
+//	array is given up too, so that the array joins the mapping of
+//	the one before it, and no new mapping is needed.
+//
+//	"pool" -- what ReserveBoundedArrays returned
+//	"size" -- amount of useful space in each array (in bytes)
+//	"i" -- which array
+//----------------------------------------------------------------------
+
+char *
+CommitBoundedArray(char *pool, int size, int i)
+{
+    int pgSize = getpagesize();
+    char *ptr;
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    ptr = pool + (pgSize + size) * i + pgSize;
+    if (mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0)
+	return ptr;
+    if (i > 0 && errno == ENOMEM
+	    && mprotect(ptr - pgSize, pgSize + size, PROT_READ | PROT_WRITE) == 0)
+	return ptr;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// DiscardBoundedArray
+// 	Let the host have back the memory behind a bounded array that
+//	won't be used for a while.  The array stays mapped, and reads as
+//	zeroes when it is next used.
+//
+//	"ptr" -- the array
+//	"size" -- amount of useful space in the array (in bytes)
+//----------------------------------------------------------------------
+
+void
+DiscardBoundedArray(char *ptr, int size)
+{
+    int pgSize = getpagesize();
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    madvise(ptr, size, MADV_DONTNEED);
+}
+
+//----------------------------------------------------------------------
+// HostSeconds
+// 	Return the host's wall clock time, in seconds.  Only useful for
+//	measuring how fast the simulation itself runs.
+//----------------------------------------------------------------------
+
+double
+HostSeconds()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+//----------------------------------------------------------------------
+// StartHostThread
+// 	Start a host thread running "func(arg)", alongside the one
+//	Nachos runs on.  "func" must never return.
+//----------------------------------------------------------------------
+
+typedef struct {
+    VoidFunctionPtr func;
+    int arg;
+} HostThreadStart;
+
+static void *
+HostThreadRoot(void *p)
+{
+    HostThreadStart *start = (HostThreadStart *) p;
+
+    (*start->func)(start->arg);
+    return NULL;
+}
+
+void
+StartHostThread(VoidFunctionPtr func, int arg)
+{
+    HostThreadStart *start = new HostThreadStart;
+    pthread_t thread;
+    int result;
+
+    start->func = func;
+    start->arg = arg;
+    result = pthread_create(&thread, NULL, HostThreadRoot, start);
+    ASSERT(result == 0);
+    pthread_detach(thread);
+}
+
+//----------------------------------------------------------------------
+// HostLock, HostUnlock, HostWait, HostWakeAll
+// 	The one lock and condition variable the host threads synchronize
+//	with.  HostWait releases the lock until some thread calls
+//	HostWakeAll, then takes it back; the caller must check again
+//	whatever it was waiting for.
+//----------------------------------------------------------------------
+
+static pthread_mutex_t hostMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hostCond = PTHREAD_COND_INITIALIZER;
+
+void
+HostLock()
+{
+    pthread_mutex_lock(&hostMutex);
+}
+
+void
+HostUnlock()
+{
+    pthread_mutex_unlock(&hostMutex);
+}
+
+void
+HostWait()
+{
+    pthread_cond_wait(&hostCond, &hostMutex);
+}
+
+void
+HostWakeAll()
+{
+    pthread_cond_broadcast(&hostCond);
 }
@@ -19,16 +19,21 @@ extern bool PollFile(int fd);
 
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
-extern int OpenForWrite(char *name);
+extern int OpenForWrite(char *name, bool crashOnError = TRUE);
 extern int OpenForReadWrite(char *name, bool crashOnError);
 extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
+extern int WritePartial(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
+// Map a whole file read-only into memory (NULL on failure), and unmap it
+extern char *MapFile(char *name, int *size);
+extern void UnmapFile(char *addr, int size);
+
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
 extern void CloseSocket(int sockID);
@@ -52,9 +57,26 @@ extern int Random();
 
 // Allocate, de-allocate an array, such that de-referencing
 // just beyond either end of the array will cause an error
-extern char *AllocBoundedArray(int size);
+extern char *AllocBoundedArray(int size);	// NULL if out of memory
 extern void DeallocBoundedArray(char *p, int size);
 
+// The same for many arrays of one size, carved out of one mapping
+extern char *ReserveBoundedArrays(int size, int count);
+extern char *CommitBoundedArray(char *pool, int size, int i);
+extern void DiscardBoundedArray(char *p, int size);	// free its memory,
+							// but keep it mapped
+
+// Host wall clock time, for benchmarks
+extern double HostSeconds();
+
+// Host threads, to run the processors of a multiprocessor in parallel,
+// and the lock and condition variable they synchronize with
+extern void StartHostThread(VoidFunctionPtr func, int arg);
+extern void HostLock();
+extern void HostUnlock();
+extern void HostWait();		// until HostWakeAll; holding HostLock
+extern void HostWakeAll();
+
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
 extern "C" {
@@ -64,6 +86,7 @@ int abs(int i);
 
 #include <stdio.h>		// for printf, fprintf
 #include <string.h>		// for DEBUG, etc.
+#include <strings.h>		// for ffs
 }
 
 #endif // SYSDEP_H
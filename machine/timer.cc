@@ -46,27 +46,69 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
     randomize = doRandom;
     handler = timerHandler;
     arg = callArg; 
+    running = FALSE;
+    outstanding = FALSE;
 
     // schedule the first interrupt from the timer device
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt); 
+    Start();
 }
 
 //----------------------------------------------------------------------
 // Timer::TimerExpired
 //      Routine to simulate the interrupt generated by the hardware 
-//	timer device.  Schedule the next interrupt, and invoke the
-//	interrupt handler.
+//	timer device.  Invoke the interrupt handler, and unless it
+//	stopped the timer, schedule the next interrupt.
+//
+//	If the timer was stopped while this interrupt was outstanding,
+//	the interrupt is simply dropped.
 //----------------------------------------------------------------------
 void 
 Timer::TimerExpired() 
 {
-    // schedule the next timer device interrupt
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt);
+    outstanding = FALSE;
+    if (!running)
+	return;
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
+
+    // schedule the next timer device interrupt
+    if (running) {
+	interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
+		TimerInt);
+	outstanding = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Start
+//      Have the timer generate interrupts again, starting one time
+//	slice from now.  Does nothing if the timer is already running.
+//----------------------------------------------------------------------
+
+void
+Timer::Start()
+{
+    if (running)
+	return;
+    running = TRUE;
+    if (!outstanding) {
+	interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
+		TimerInt);
+	outstanding = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Stop generating timer interrupts.  An interrupt already
+//	scheduled is left in the queue, and ignored when it fires.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    running = FALSE;
 }
 
 //----------------------------------------------------------------------
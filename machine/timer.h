@@ -36,6 +36,11 @@ class Timer {
     void TimerExpired();	// called internally when the hardware
 				// timer generates an interrupt
 
+    void Start();		// (re)start generating interrupts
+    void Stop();		// stop generating interrupts, until
+				// the next Start
+    bool IsRunning() { return running; }
+
     int TimeOfNextInterrupt();  // figure out when the timer will generate
 				// its next interrupt 
 
@@ -43,6 +48,8 @@ class Timer {
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
     int arg;			// argument to pass to interrupt handler
+    bool running;		// set if the timer should keep ticking
+    bool outstanding;		// set if a timer interrupt is scheduled
 
 };
 
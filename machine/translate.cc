@@ -82,10 +82,11 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
+//	"access" -- who is reading, for the caches
 //----------------------------------------------------------------------
 
 bool
-Machine::ReadMem(int addr, int size, int *value)
+Machine::ReadMem(int addr, int size, int *value, MemAccess access)
 {
     int data;
     ExceptionType exception;
@@ -95,27 +96,29 @@ Machine::ReadMem(int addr, int size, int *value)
     
     exception = Translate(addr, &physicalAddress, size, FALSE);
     if (exception != NoException) {
-		machine->RaiseException(exception, addr);
+		RaiseException(exception, addr);
 		return FALSE;
     }
     switch (size) {
       case 1:
-		data = machine->mainMemory[physicalAddress];
+		data = mainMemory[physicalAddress];
 		*value = data;
 		break;
 	
       case 2:
-		data = *(unsigned short *) &machine->mainMemory[physicalAddress];
+		data = *(unsigned short *) &mainMemory[physicalAddress];
 		*value = ShortToHost(data);
 		break;
 	
       case 4:
-		data = *(unsigned int *) &machine->mainMemory[physicalAddress];
+		data = *(unsigned int *) &mainMemory[physicalAddress];
 		*value = WordToHost(data);
 		break;
 
       default: ASSERT(FALSE);
     }
+    if (access != KernelAccess)
+	CacheAccess(physicalAddress, access, FALSE);
     
     DEBUG('a', "\tvalue read = %8.8x\n", *value);
     return (TRUE);
@@ -132,10 +135,11 @@ Machine::ReadMem(int addr, int size, int *value)
 //	"addr" -- the virtual address to write to
 //	"size" -- the number of bytes to be written (1, 2, or 4)
 //	"value" -- the data to be written
+//	"access" -- who is writing, for the caches
 //----------------------------------------------------------------------
 
 bool
-Machine::WriteMem(int addr, int size, int value)
+Machine::WriteMem(int addr, int size, int value, MemAccess access)
 {
     ExceptionType exception;
     int physicalAddress;
@@ -144,30 +148,67 @@ Machine::WriteMem(int addr, int size, int value)
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
     if (exception != NoException) {
-		machine->RaiseException(exception, addr);
+		RaiseException(exception, addr);
 		return FALSE;
     }
     switch (size) {
       case 1:
-		machine->mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+		mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
 		break;
 
       case 2:
-		*(unsigned short *) &machine->mainMemory[physicalAddress]
+		*(unsigned short *) &mainMemory[physicalAddress]
 			= ShortToMachine((unsigned short) (value & 0xffff));
 		break;
       
       case 4:
-		*(unsigned int *) &machine->mainMemory[physicalAddress]
+		*(unsigned int *) &mainMemory[physicalAddress]
 			= WordToMachine((unsigned int) value);
 		break;
 	
       default: ASSERT(FALSE);
     }
+    if (access != KernelAccess)
+	CacheAccess(physicalAddress, access, TRUE);
     
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::CacheAccess
+// 	Run an access by a user instruction through the cache for its
+//	kind, if there is one, and charge the process for it.  On a miss,
+//	stall the CPU for missPenalty ticks, unless the access is a
+//	write that a write-through cache just passes on to memory.
+//
+//	"physAddr" -- the physical address accessed
+//	"access" -- an instruction fetch, or a load or store
+//	"writing" -- TRUE for a store
+//----------------------------------------------------------------------
+
+void
+Machine::CacheAccess(int physAddr, MemAccess access, bool writing)
+{
+    Cache *cache = (access == FetchAccess) ? icache : dcache;
+
+    if (cache == NULL)
+	return;
+    AddUsage(ResCacheAccesses, 1);
+    if (cache->Access(physAddr, writing))
+	return;
+    AddUsage(ResCacheMisses, 1);
+    if (missPenalty > 0 && (!writing || cache->IsWriteBack())) {
+	if (onHost) {			// the kernel adds it to the clock
+	    hostStall += missPenalty;
+	    return;
+	}
+	stats->totalTicks += missPenalty;
+	stats->userTicks += missPenalty;
+	stats->cacheStallTicks += missPenalty;
+	currentThread->AddUsage(ResUserTicks, missPenalty);
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -177,6 +218,9 @@ Machine::WriteMem(int addr, int size, int value)
 //	address in "physAddr".  If there was an error, returns the type
 //	of the exception.
 //
+//	On a CPU's host thread, a TLB miss on a page that is in memory is
+//	refilled from the page table here, rather than by the kernel.
+//
 //	"virtAddr" -- the virtual address to translate
 //	"physAddr" -- the place to store the physical address
 //	"size" -- the amount of memory being read or written
@@ -186,7 +230,7 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
+    int i, j;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
@@ -214,24 +258,46 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	//首先查找TLB
 	//维护LRU_mark，每项先+1,后面命中则令某一项为0
 	for(int k = 0; k < TLBSize; k++){
-		machine->LRU_mark[k]++;
+		LRU_mark[k]++;
 	}
 	for (entry = NULL, i = 0; i < TLBSize; i++)
 		if (tlb[i].valid && (tlb[i].virtualPage == vpn)) {
 			entry = &tlb[i];			// FOUND!
 			//维护LRU_mark
-			machine->LRU_mark[i] = 0;
-			machine->tlb_hit++;
+			LRU_mark[i] = 0;
+			tlb_hit++;
 			break;
 		}
 	if (entry == NULL) {				// not found
 		DEBUG('a', "*** no valid TLB entry found for this virtual page!\n");
-		machine->tlb_miss++;
+		tlb_miss++;
+		AddUsage(ResTLBMisses, 1);
 		//启动TLB却页异常处理
 		//machine->RaiseException(TLBPageFaultException, virtAddr);
-		return PageFaultException;		// really, this is a TLB fault,
+		//在CPU的宿主线程上，页已在内存中时直接从页表装入TLB，像硬件
+		//查页表一样，不必回到内核；只有真正缺页才回去（见cpu.h）
+		if (!onHost || pageTable == NULL || vpn >= pageTableSize
+				|| !pageTable[vpn].valid)
+			return PageFaultException;	// really, this is a TLB fault,
 					// the page may be in memory,
 					// but not in the TLB
+		//替换空闲项，没有则替换LRU_mark最大的
+		for (j = 0, i = 0; i < TLBSize; i++) {
+			if (!tlb[i].valid) {
+				j = i;
+				break;
+			}
+			if (LRU_mark[i] > LRU_mark[j])
+				j = i;
+		}
+		entry = &tlb[j];
+		entry->valid = TRUE;
+		entry->virtualPage = vpn;
+		entry->physicalPage = pageTable[vpn].physicalPage;
+		entry->use = FALSE;
+		entry->dirty = FALSE;
+		entry->readOnly = FALSE;
+		LRU_mark[j] = 0;
 	}
 	
 
@@ -0,0 +1,41 @@
+/* filebench.c 
+ *    Benchmark: write a file in CHUNKS pieces of CHUNK bytes, then read
+ *    it back the same way, to time the file system calls.
+ */
+
+#include "syscall.h"
+
+#define CHUNK	64
+#ifndef CHUNKS
+#define CHUNKS	32
+#endif
+
+char buffer[CHUNK];
+
+int
+main()
+{
+    OpenFileId id;
+    int i, n, total;
+
+    for (i = 0; i < CHUNK; i++)
+	buffer[i] = 'a' + i % 26;
+
+    Create("bench.dat");
+    id = Open("bench.dat");
+    for (i = 0; i < CHUNKS; i++)
+	Write(buffer, CHUNK, id);
+    Close(id);
+
+    total = 0;
+    id = Open("bench.dat");
+    for (i = 0; i < CHUNKS; i++) {
+	n = Read(buffer, CHUNK, id);
+	if (n <= 0)
+	    break;
+	total += n;
+    }
+    Close(id);
+
+    Exit(total);	/* should be CHUNKS * CHUNK */
+}
@@ -0,0 +1,42 @@
+/* forkbench.c 
+ *    Benchmark: fork FORKS user threads, each of which does nothing but
+ *    exit, and wait for them all; then exec and join EXECS copies of
+ *    a trivial program.  Times thread and process creation.
+ *
+ *    Every exec takes its pages of the swap area for good, so only a
+ *    couple fit.
+ */
+
+#include "syscall.h"
+
+#ifndef FORKS
+#define FORKS	16
+#endif
+#define EXECS	2
+
+int done;		/* touched before forking, so the children share it */
+
+void
+child()
+{
+    done++;
+    Exit(0);
+}
+
+int
+main()
+{
+    int i, code;
+
+    done = 0;
+    for (i = 0; i < FORKS; i++)
+	Fork(child);
+    while (done < FORKS)
+	Yield();
+
+    code = 0;
+    for (i = 0; i < EXECS; i++)
+	code += Join(Exec("nop"));
+
+    Exit(code);		/* should be 0 */
+}
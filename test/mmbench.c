@@ -0,0 +1,35 @@
+/* mmbench.c 
+ *    Benchmark: multiply two N by N matrices (N is set by the Makefile,
+ *    with -DN=...), to time user computation and, for larger N,
+ *    demand paging.  Physical memory is only 4KB, so N can't be large.
+ */
+
+#include "syscall.h"
+
+#ifndef N
+#define N	8
+#endif
+
+int A[N][N];
+int B[N][N];
+int C[N][N];
+
+int
+main()
+{
+    int i, j, k;
+
+    for (i = 0; i < N; i++)
+	for (j = 0; j < N; j++) {
+	    A[i][j] = i;
+	    B[i][j] = j;
+	    C[i][j] = 0;
+	}
+
+    for (i = 0; i < N; i++)
+	for (j = 0; j < N; j++)
+	    for (k = 0; k < N; k++)
+		C[i][j] += A[i][k] * B[k][j];
+
+    Exit(C[N-1][N-1]);
+}
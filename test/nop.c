@@ -0,0 +1,11 @@
+/* nop.c 
+ *    The smallest program: exits at once.  Exec'ed by forkbench.
+ */
+
+#include "syscall.h"
+
+int
+main()
+{
+    Exit(0);
+}
@@ -0,0 +1,32 @@
+/* sortbench.c 
+ *    Benchmark: bubble sort N integers (N is set by the Makefile, with
+ *    -DN=...), starting in reverse order, so that every comparison
+ *    swaps.
+ */
+
+#include "syscall.h"
+
+#ifndef N
+#define N	64
+#endif
+
+int A[N];
+
+int
+main()
+{
+    int i, j, tmp;
+
+    for (i = 0; i < N; i++)
+        A[i] = N - i;
+
+    for (i = 0; i < N - 1; i++)
+        for (j = 0; j < N - 1 - i; j++)
+            if (A[j] > A[j + 1]) {
+                tmp = A[j];
+                A[j] = A[j + 1];
+                A[j + 1] = tmp;
+            }
+
+    Exit(A[0]);		/* should be 1 */
+}
@@ -130,6 +130,22 @@ Yield:
 	j	$31
 	.end Yield
 
+	.globl Checkpoint
+	.ent	Checkpoint
+Checkpoint:
+	addiu $2,$0,SC_Checkpoint
+	syscall
+	j	$31
+	.end Checkpoint
+
+	.globl GetStats
+	.ent	GetStats
+GetStats:
+	addiu $2,$0,SC_GetStats
+	syscall
+	j	$31
+	.end GetStats
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
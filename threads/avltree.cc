@@ -0,0 +1,330 @@
+// avltree.cc 
+//	Routines to manage a balanced binary search tree.  See avltree.h
+//	for a description.
+//
+//	The tree operations are written recursively: each one returns
+//	the new root of the subtree it was given, rebalanced on the way
+//	back up.  The depth of the recursion is the height of the tree,
+//	which is O(log n).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "avltree.h"
+
+// As with list elements, nodes are recycled through a free list
+// (chained through "right") rather than given back to the heap.
+static TreeNode *freeNodes = NULL;
+
+//----------------------------------------------------------------------
+// TreeNode::TreeNode
+// 	Initialize a tree node, so it can be added to the tree as a leaf.
+//
+//	"itemPtr" is the item to be put in the tree.
+//	"sortKey", "tieKey" determine where in the tree it goes.
+//----------------------------------------------------------------------
+
+TreeNode::TreeNode(void *itemPtr, int sortKey, int tieKey)
+{
+    left = right = NULL;
+    height = 1;
+    key = sortKey;
+    tie = tieKey;
+    item = itemPtr;
+}
+
+//----------------------------------------------------------------------
+// TreeNode::operator new, TreeNode::operator delete
+// 	Allocate tree nodes from, and return them to, the free list.
+//----------------------------------------------------------------------
+
+void *
+TreeNode::operator new(size_t size)
+{
+    TreeNode *node;
+
+    ASSERT(size == sizeof(TreeNode));
+    if (freeNodes != NULL) {
+	node = freeNodes;
+	freeNodes = node->right;
+    } else
+	node = (TreeNode *) ::operator new(size);
+    return node;
+}
+
+void
+TreeNode::operator delete(void *p)
+{
+    TreeNode *node = (TreeNode *) p;
+
+    node->right = freeNodes;
+    freeNodes = node;
+}
+
+//----------------------------------------------------------------------
+// Height, Fix, RotateRight, RotateLeft, Balance
+// 	Helpers to keep the tree balanced.  Fix recomputes the height of
+//	a node from its children; Balance rotates a node whose subtrees
+//	differ in height by two, and returns the new root of the subtree.
+//----------------------------------------------------------------------
+
+static int
+Height(TreeNode *node)
+{
+    return (node == NULL) ? 0 : node->height;
+}
+
+static void
+Fix(TreeNode *node)
+{
+    int l = Height(node->left), r = Height(node->right);
+
+    node->height = ((l > r) ? l : r) + 1;
+}
+
+static TreeNode *
+RotateRight(TreeNode *node)
+{
+    TreeNode *top = node->left;
+
+    node->left = top->right;
+    top->right = node;
+    Fix(node);
+    Fix(top);
+    return top;
+}
+
+static TreeNode *
+RotateLeft(TreeNode *node)
+{
+    TreeNode *top = node->right;
+
+    node->right = top->left;
+    top->left = node;
+    Fix(node);
+    Fix(top);
+    return top;
+}
+
+static TreeNode *
+Balance(TreeNode *node)
+{
+    Fix(node);
+    if (Height(node->left) > Height(node->right) + 1) {
+	if (Height(node->left->right) > Height(node->left->left))
+	    node->left = RotateLeft(node->left);
+	return RotateRight(node);
+    }
+    if (Height(node->right) > Height(node->left) + 1) {
+	if (Height(node->right->left) > Height(node->right->right))
+	    node->right = RotateRight(node->right);
+	return RotateLeft(node);
+    }
+    return node;
+}
+
+//----------------------------------------------------------------------
+// Before
+// 	Return TRUE if (key1, tie1) sorts before (key2, tie2).
+//----------------------------------------------------------------------
+
+static bool
+Before(int key1, int tie1, int key2, int tie2)
+{
+    if (key1 != key2)
+	return (key1 < key2);
+    return (tie1 < tie2);
+}
+
+//----------------------------------------------------------------------
+// InsertNode, RemoveMinNode, RemoveNode, DeleteAll, MapNodes
+// 	Recursive versions of the tree operations, on the subtree rooted
+//	at "node".  Those that change the tree return its new root.
+//----------------------------------------------------------------------
+
+static TreeNode *
+InsertNode(TreeNode *node, TreeNode *leaf)
+{
+    if (node == NULL)
+	return leaf;
+    if (Before(leaf->key, leaf->tie, node->key, node->tie))
+	node->left = InsertNode(node->left, leaf);
+    else
+	node->right = InsertNode(node->right, leaf);
+    return Balance(node);
+}
+
+static TreeNode *
+RemoveMinNode(TreeNode *node, TreeNode **minPtr)
+{
+    if (node->left == NULL) {
+	*minPtr = node;
+	return node->right;
+    }
+    node->left = RemoveMinNode(node->left, minPtr);
+    return Balance(node);
+}
+
+static TreeNode *
+RemoveNode(TreeNode *node, int key, int tie, TreeNode **foundPtr)
+{
+    TreeNode *successor;
+
+    if (node == NULL)
+	return NULL;
+    if (Before(key, tie, node->key, node->tie))
+	node->left = RemoveNode(node->left, key, tie, foundPtr);
+    else if (Before(node->key, node->tie, key, tie))
+	node->right = RemoveNode(node->right, key, tie, foundPtr);
+    else {
+	*foundPtr = node;
+	if (node->left == NULL)
+	    return node->right;
+	if (node->right == NULL)
+	    return node->left;
+	// replace the node by the smallest item after it
+	node->right = RemoveMinNode(node->right, &successor);
+	successor->left = node->left;
+	successor->right = node->right;
+	node = successor;
+    }
+    return Balance(node);
+}
+
+static void
+DeleteAll(TreeNode *node)
+{
+    if (node != NULL) {
+	DeleteAll(node->left);
+	DeleteAll(node->right);
+	delete node;
+    }
+}
+
+static void
+MapNodes(TreeNode *node, VoidFunctionPtr func)
+{
+    if (node != NULL) {
+	MapNodes(node->left, func);
+	(*func)((int)node->item);
+	MapNodes(node->right, func);
+    }
+}
+
+//----------------------------------------------------------------------
+// AVLTree::AVLTree
+//	Initialize a tree, empty to start with.
+//----------------------------------------------------------------------
+
+AVLTree::AVLTree()
+{
+    root = NULL;
+    numInTree = 0;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::~AVLTree
+//	De-allocate the nodes of the tree.  As with a List, the items
+//	themselves are not de-allocated.
+//----------------------------------------------------------------------
+
+AVLTree::~AVLTree()
+{
+    DeleteAll(root);
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Insert
+//	Put an item in the tree, in order by (key, tie).
+//
+//	"item" is the thing to put in the tree.
+//	"key", "tie" are its sort keys.
+//----------------------------------------------------------------------
+
+void
+AVLTree::Insert(void *item, int key, int tie)
+{
+    root = InsertNode(root, new TreeNode(item, key, tie));
+    numInTree++;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::RemoveMin
+//	Take the smallest item out of the tree, and return it.
+//	Return NULL if the tree is empty.
+//
+//	"keyPtr" -- if not NULL, set to the key of the removed item.
+//----------------------------------------------------------------------
+
+void *
+AVLTree::RemoveMin(int *keyPtr)
+{
+    TreeNode *min;
+    void *item;
+
+    if (root == NULL)
+	return NULL;
+    root = RemoveMinNode(root, &min);
+    item = min->item;
+    if (keyPtr != NULL)
+	*keyPtr = min->key;
+    delete min;
+    numInTree--;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Remove
+//	Take the item with sort keys (key, tie) out of the tree.
+//	Return FALSE if there is no such item.
+//----------------------------------------------------------------------
+
+bool
+AVLTree::Remove(int key, int tie)
+{
+    TreeNode *found = NULL;
+
+    root = RemoveNode(root, key, tie, &found);
+    if (found == NULL)
+	return FALSE;
+    delete found;
+    numInTree--;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Min
+//	Return the smallest item in the tree, without taking it out.
+//	Return NULL if the tree is empty.
+//
+//	"keyPtr" -- if not NULL, set to the key of the item.
+//----------------------------------------------------------------------
+
+void *
+AVLTree::Min(int *keyPtr)
+{
+    TreeNode *node = root;
+
+    if (node == NULL)
+	return NULL;
+    while (node->left != NULL)
+	node = node->left;
+    if (keyPtr != NULL)
+	*keyPtr = node->key;
+    return node->item;
+}
+
+//----------------------------------------------------------------------
+// AVLTree::Mapcar
+//	Apply a function to each item in the tree, in sorted order.
+//
+//	"func" is the procedure to apply to each item.
+//----------------------------------------------------------------------
+
+void
+AVLTree::Mapcar(VoidFunctionPtr func)
+{
+    MapNodes(root, func);
+}
@@ -0,0 +1,64 @@
+// avltree.h 
+//	Data structures for a balanced binary search tree.
+//
+//	Like a List, the tree holds "void *" items, but keeps them sorted
+//	by key (and, between equal keys, by a second "tie" key), and
+//	inserting, removing and finding the smallest item all take
+//	O(log n) time.  The tree is kept balanced with the AVL rule: the
+//	heights of the two subtrees of any node differ by at most one.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef AVLTREE_H
+#define AVLTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a "tree node" -- used to keep track
+// of one item in the tree.  Internal data structures kept public so
+// that AVLTree operations can access them directly.
+
+class TreeNode {
+  public:
+    TreeNode(void *itemPtr, int sortKey, int tieKey);
+				// initialize a leaf holding itemPtr
+
+    void *operator new(size_t size);	// allocate from the free list,
+    void operator delete(void *p);	// and recycle onto it
+
+    TreeNode *left;		// items sorting before this one
+    TreeNode *right;		// items sorting after this one
+    int height;			// height of the subtree, 1 for a leaf
+    int key;			// primary sort key
+    int tie;			// breaks ties between equal keys
+    void *item;			// pointer to the item in the tree
+};
+
+// The following class defines the tree itself.  (key, tie) pairs
+// are expected to be unique.
+
+class AVLTree {
+  public:
+    AVLTree();			// initialize an empty tree
+    ~AVLTree();			// de-allocate the tree
+
+    void Insert(void *item, int key, int tie);	// put item in the tree
+    void *RemoveMin(int *keyPtr);	// take the smallest item out,
+					// NULL if the tree is empty
+    bool Remove(int key, int tie);	// take a specific item out
+    void *Min(int *keyPtr);		// smallest item, left in the tree
+
+    bool IsEmpty() { return (root == NULL); }
+    int NumInTree() { return numInTree; }
+    void Mapcar(VoidFunctionPtr func);	// apply func to every item,
+					// in sorted order
+
+  private:
+    TreeNode *root;		// NULL if the tree is empty
+    int numInTree;		// number of items in the tree
+};
+
+#endif // AVLTREE_H
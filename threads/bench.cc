@@ -0,0 +1,301 @@
+// bench.cc
+//	Routines to time kernel data structures on the host, and the
+//	benchmarks themselves.  See bench.h for how they are run.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "bench.h"
+#include "list.h"
+#include "synchlist.h"
+#ifdef USER_PROGRAM
+#include "bitmap.h"
+#endif
+#ifdef FILESYS
+#include "directory.h"
+#endif
+
+//----------------------------------------------------------------------
+// List: append to the end and remove from the front, as the ready
+// lists and wait queues do; and keep a sorted list, as the old
+// interrupt queue did.
+//----------------------------------------------------------------------
+
+static List *benchList;
+
+static void
+ListSetup(int ops)
+{
+    benchList = new List;
+}
+
+static void
+ListCleanup(int ops)
+{
+    delete benchList;
+}
+
+static void
+ListAppendRemove(int ops)
+{
+    for (int i = 0; i < ops; i++)
+	benchList->Append((void *) i);
+    for (int i = 0; i < ops; i++)
+	(void) benchList->Remove();
+}
+
+static void
+ListSorted(int ops)
+{
+    int key;
+
+    for (int i = 0; i < ops; i++)
+	benchList->SortedInsert((void *) i, Random() % ops);
+    for (int i = 0; i < ops; i++)
+	(void) benchList->SortedRemove(&key);
+}
+
+//----------------------------------------------------------------------
+// SynchList: the same, with the lock taken on every operation.  The
+// list is never empty when Remove is called, so nothing waits.
+//----------------------------------------------------------------------
+
+static SynchList *benchSynchList;
+
+static void
+SynchListSetup(int ops)
+{
+    benchSynchList = new SynchList;
+}
+
+static void
+SynchListCleanup(int ops)
+{
+    delete benchSynchList;
+}
+
+static void
+SynchListAppendRemove(int ops)
+{
+    for (int i = 0; i < ops; i++)
+	benchSynchList->Append((void *) i);
+    for (int i = 0; i < ops; i++)
+	(void) benchSynchList->Remove();
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Schedule: put interrupts at random times on the pending
+// queue of an interrupt controller of our own, so that none of them
+// ever fires.
+//----------------------------------------------------------------------
+
+static Interrupt *benchInterrupt;
+
+static void
+BenchHandler(int arg)
+{
+}
+
+static void
+ScheduleSetup(int ops)
+{
+    benchInterrupt = new Interrupt;
+}
+
+static void
+ScheduleCleanup(int ops)
+{
+    delete benchInterrupt;		// throws the pending ones away
+}
+
+static void
+Schedule(int ops)
+{
+    for (int i = 0; i < ops; i++)
+	benchInterrupt->Schedule(BenchHandler, i, 1 + Random() % 10000,
+				 TimerInt);
+}
+
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// BitMap: allocate every bit of a map, one Find at a time, as the
+// frame and sector allocators do.
+//----------------------------------------------------------------------
+
+static BitMap *benchMap;
+
+static void
+BitMapSetup(int ops)
+{
+    benchMap = new BitMap(ops);
+}
+
+static void
+BitMapCleanup(int ops)
+{
+    delete benchMap;
+}
+
+static void
+BitMapFind(int ops)
+{
+    for (int i = 0; i < ops; i++)
+	(void) benchMap->Find();
+}
+#endif // USER_PROGRAM
+
+#ifdef USE_TLB
+//----------------------------------------------------------------------
+// Machine::Translate: translate addresses that hit in the TLB, the
+// common case for every user load, store and instruction fetch.
+// The TLB is loaded with pages of our own, and put back afterwards.
+//----------------------------------------------------------------------
+
+static TranslationEntry savedTLB[TLBSize];
+
+static void
+TranslateSetup(int ops)
+{
+    for (int i = 0; i < TLBSize; i++) {
+	savedTLB[i] = machine->tlb[i];
+	machine->tlb[i].virtualPage = i;
+	machine->tlb[i].physicalPage = i;
+	machine->tlb[i].valid = TRUE;
+	machine->tlb[i].readOnly = FALSE;
+    }
+}
+
+static void
+TranslateCleanup(int ops)
+{
+    for (int i = 0; i < TLBSize; i++)
+	machine->tlb[i] = savedTLB[i];
+}
+
+static void
+Translate(int ops)
+{
+    int physAddr;
+
+    for (int i = 0; i < ops; i++)
+	(void) machine->Translate((i * 52) % (TLBSize * PageSize), &physAddr,
+				  4, FALSE);
+}
+#endif // USE_TLB
+
+#ifdef FILESYS
+//----------------------------------------------------------------------
+// Directory::Find: look up names in a full directory.
+//----------------------------------------------------------------------
+
+#define BenchDirSize 64
+
+static Directory *benchDirectory;
+static char benchNames[BenchDirSize][FileNameMaxLen + 1];
+
+static void
+DirectorySetup(int ops)
+{
+    benchDirectory = new Directory(BenchDirSize);
+    for (int i = 0; i < BenchDirSize; i++) {
+	sprintf(benchNames[i], "file%d", i);
+	benchDirectory->Add(benchNames[i], i + 2, FALSE);
+    }
+}
+
+static void
+DirectoryCleanup(int ops)
+{
+    delete benchDirectory;
+}
+
+static void
+DirectoryFind(int ops)
+{
+    for (int i = 0; i < ops; i++)
+	(void) benchDirectory->Find(benchNames[(i * 7) % BenchDirSize]);
+}
+#endif // FILESYS
+
+static Benchmark benchmarks[] = {
+    { "list.append",	ListSetup, ListAppendRemove, ListCleanup, 20000 },
+    { "list.sorted",	ListSetup, ListSorted, ListCleanup, 1000 },
+    { "synchlist",	SynchListSetup, SynchListAppendRemove,
+			SynchListCleanup, 20000 },
+    { "interrupt.schedule", ScheduleSetup, Schedule, ScheduleCleanup, 10000 },
+#ifdef USER_PROGRAM
+    { "bitmap.find",	BitMapSetup, BitMapFind, BitMapCleanup, 1024 },
+#endif
+#ifdef USE_TLB
+    { "translate",	TranslateSetup, Translate, TranslateCleanup, 100000 },
+#endif
+#ifdef FILESYS
+    { "directory.find",	DirectorySetup, DirectoryFind, DirectoryCleanup,
+			50000 },
+#endif
+};
+
+#define NumBenchmarks ((int) (sizeof(benchmarks) / sizeof(Benchmark)))
+
+//----------------------------------------------------------------------
+// RunBenchmark
+// 	Time BenchWarmups + BenchBatches batches of "bench", and print
+//	the nanoseconds per operation of the timed ones: the fastest,
+//	the median, the 90th percentile, the slowest and the mean.
+//----------------------------------------------------------------------
+
+void
+RunBenchmark(Benchmark *bench)
+{
+    double nsPerOp[BenchBatches], start, t, sum = 0;
+    int i, j;
+
+    for (i = -BenchWarmups; i < BenchBatches; i++) {
+	if (bench->setup != NULL)
+	    (*bench->setup)(bench->ops);
+	start = HostSeconds();
+	(*bench->run)(bench->ops);
+	t = (HostSeconds() - start) * 1e9 / bench->ops;
+	if (bench->cleanup != NULL)
+	    (*bench->cleanup)(bench->ops);
+	if (i < 0)
+	    continue;			// warming up
+	for (j = i; j > 0 && nsPerOp[j - 1] > t; j--)	// keep them sorted
+	    nsPerOp[j] = nsPerOp[j - 1];
+	nsPerOp[j] = t;
+	sum += t;
+    }
+    printf("  %-20s %8d %9.1f %9.1f %9.1f %9.1f %9.1f\n", bench->name,
+	bench->ops, nsPerOp[0], nsPerOp[BenchBatches / 2],
+	nsPerOp[BenchBatches * 9 / 10], nsPerOp[BenchBatches - 1],
+	sum / BenchBatches);
+}
+
+//----------------------------------------------------------------------
+// RunBenchmarks
+// 	Run the benchmarks whose names start with "prefix", or all of
+//	them if it is "all".
+//----------------------------------------------------------------------
+
+void
+RunBenchmarks(char *prefix)
+{
+    int found = 0;
+
+    printf("Benchmarks (%d batches after %d warm-ups; ns per operation):\n",
+	BenchBatches, BenchWarmups);
+    printf("  %-20s %8s %9s %9s %9s %9s %9s\n", "name", "ops", "min",
+	"median", "90%", "max", "mean");
+    for (int i = 0; i < NumBenchmarks; i++) {
+	if (strcmp(prefix, "all")
+		&& strncmp(benchmarks[i].name, prefix, strlen(prefix)))
+	    continue;
+	RunBenchmark(&benchmarks[i]);
+	found++;
+    }
+    if (found == 0)
+	printf("No benchmark named %s in this configuration\n", prefix);
+}
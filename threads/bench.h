@@ -0,0 +1,44 @@
+// bench.h
+//	Data structures for timing kernel data structures on the host.
+//
+//	"nachos -bench <name>" runs the benchmarks whose names start
+//	with <name> ("all" runs them all), and halts.  Each benchmark
+//	does a batch of operations on one data structure, and is timed
+//	with the host's wall clock, not simulated time.  The first few
+//	batches warm up the host's caches and are thrown away; the
+//	others give the time per operation, and the spread of those
+//	times over the batches.
+//
+//	Which benchmarks there are depends on the configuration: the
+//	address translation ones need a TLB (userprog), and the directory
+//	ones need the file system (filesys).  "make bench" at the top
+//	level runs both.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define BenchWarmups	3	// batches thrown away
+#define BenchBatches	25	// batches timed
+
+// A benchmark: "run" does "ops" operations.  "setup" and "cleanup",
+// if not NULL, are called before and after each batch, outside the
+// timing, with the same argument.
+typedef struct benchmark {
+    char *name;
+    VoidFunctionPtr setup;
+    VoidFunctionPtr run;
+    VoidFunctionPtr cleanup;
+    int ops;			// operations per batch
+} Benchmark;
+
+extern void RunBenchmark(Benchmark *bench);	// time one benchmark
+extern void RunBenchmarks(char *prefix);	// ... and all that match
+
+#endif // BENCH_H
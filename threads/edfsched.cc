@@ -0,0 +1,253 @@
+// edfsched.cc 
+//	Routines for earliest-deadline-first real-time scheduling.  See
+//	edfsched.h for a description.
+//
+//	Two kinds of software alarm are scheduled on the interrupt queue:
+//	a release, when a waiting or throttled thread's next period
+//	starts, and a budget alarm, when the running thread will have
+//	used up its budget.  A budget alarm is only honoured if the same
+//	dispatch of the same thread is still running when it goes off;
+//	each dispatch gets a new sequence number to check this.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "edfsched.h"
+#include "system.h"
+
+static int dispatchSeq = 0;	// sequence number of the last dispatch
+static int budgetSeq = 0;	// dispatch whose budget alarm is live,
+				// 0 if none
+
+//----------------------------------------------------------------------
+// PeriodRelease
+// 	Start the next period of a periodic thread that was waiting for
+//	it (or was throttled), and make it ready.  If it has an earlier
+//	deadline than the thread that was interrupted, preempt that one.
+//
+//	"arg" is the thread to release.
+//----------------------------------------------------------------------
+
+static void
+PeriodRelease(int arg)
+{
+    Thread *thread = (Thread *)arg;
+
+    thread->deadline += thread->period;
+    thread->used = 0;
+    DEBUG('t', "Releasing \"%s\", deadline %d\n", thread->getName(),
+		thread->deadline);
+    scheduler->ReadyToRun(thread);
+    if (currentThread->period == 0 || thread->deadline < currentThread->deadline)
+	interrupt->YieldOnReturn();
+}
+
+//----------------------------------------------------------------------
+// BudgetExpired
+// 	The running periodic thread has used up its budget; make it
+//	yield, so that Enqueue throttles it.
+//
+//	"seq" is the dispatch the alarm was set for.
+//----------------------------------------------------------------------
+
+static void
+BudgetExpired(int seq)
+{
+    if (seq == budgetSeq && interrupt->getStatus() != IdleMode)
+	interrupt->YieldOnReturn();
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::EDFScheduler
+// 	Initialize the ready queues to empty.
+//----------------------------------------------------------------------
+
+EDFScheduler::EDFScheduler()
+{
+    deadlines = new AVLTree;
+    background = new RunQueue;
+    utilization = 0;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::~EDFScheduler
+// 	De-allocate the ready queues.
+//----------------------------------------------------------------------
+
+EDFScheduler::~EDFScheduler()
+{
+    delete deadlines;
+    delete background;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::AdmitPeriodic
+// 	Make a thread periodic, if the total utilization allows it.
+//	Its first period starts now.  Return FALSE if it is refused.
+//
+//	"thread" is the thread asking.
+//	"period", "budget" are in ticks; budget <= period.
+//----------------------------------------------------------------------
+
+bool
+EDFScheduler::AdmitPeriodic(Thread *thread, int period, int budget)
+{
+    int share;
+
+    ASSERT((budget > 0) && (budget <= period) && (thread->period == 0));
+    share = (budget * FullUtilization + period - 1) / period;	// round up
+    if (utilization + share > FullUtilization) {
+	DEBUG('t', "Refusing \"%s\": utilization %d + %d\n",
+		thread->getName(), utilization, share);
+	return FALSE;
+    }
+    utilization += share;
+    thread->period = period;
+    thread->budget = budget;
+    thread->deadline = stats->totalTicks + period;
+    thread->used = 0;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::EndPeriodic
+// 	A periodic thread is going away; give back its utilization.
+//----------------------------------------------------------------------
+
+void
+EDFScheduler::EndPeriodic(Thread *thread)
+{
+    if (thread->period == 0)
+	return;
+    utilization -= (thread->budget * FullUtilization + thread->period - 1)
+				/ thread->period;
+    thread->period = 0;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::WaitForNextPeriod
+// 	The current job of the running thread is done.  Count a deadline
+//	miss if it is late.  If its next period has already started (it
+//	overran by more than a period) it goes on at once, with the
+//	deadline of the current period; otherwise it waits for the end
+//	of this period.
+//
+//	Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+EDFScheduler::WaitForNextPeriod(Thread *thread)
+{
+    ASSERT(thread == currentThread && thread->period > 0);
+    stats->numJobs++;
+    if (stats->totalTicks > thread->deadline) {
+	stats->numDeadlineMisses++;
+	thread->deadlineMisses++;
+	DEBUG('t', "\"%s\" missed its deadline %d by %d ticks\n",
+		thread->getName(), thread->deadline,
+		stats->totalTicks - thread->deadline);
+    }
+    if (stats->totalTicks >= thread->deadline) {
+	while (thread->deadline <= stats->totalTicks)
+	    thread->deadline += thread->period;
+	thread->used = 0;
+	return;
+    }
+    interrupt->Schedule(PeriodRelease, (int)thread,
+		thread->deadline - stats->totalTicks, SchedulerInt);
+    thread->Sleep();
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Enqueue
+// 	Put a ready thread away: periodic threads by deadline, others by
+//	priority.  A periodic thread that has used up its budget isn't
+//	put on any queue; it stays blocked until its next period.
+//
+//	"thread" is the thread to put away.
+//----------------------------------------------------------------------
+
+void
+EDFScheduler::Enqueue(Thread *thread)
+{
+    if (thread->period == 0) {
+	background->Append(thread);
+	return;
+    }
+    if (thread->used >= thread->budget) {
+	int wait = thread->deadline - stats->totalTicks;
+
+	DEBUG('t', "Throttling \"%s\" until %d\n", thread->getName(),
+		thread->deadline);
+	stats->numThrottles++;
+	thread->setStatus(BLOCKED);
+	interrupt->Schedule(PeriodRelease, (int)thread,
+		(wait > 0) ? wait : 1, SchedulerInt);
+	return;
+    }
+    deadlines->Insert((void *)thread, thread->deadline, thread->getTid());
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Dequeue
+// 	Take the periodic thread with the earliest deadline, or if there
+//	is none, the highest priority other thread.  Set an alarm for
+//	when a periodic thread's budget will run out.
+//----------------------------------------------------------------------
+
+Thread *
+EDFScheduler::Dequeue()
+{
+    Thread *thread = (Thread *)deadlines->RemoveMin(NULL);
+
+    if (thread == NULL) {
+	budgetSeq = 0;
+	return background->Remove();
+    }
+    budgetSeq = ++dispatchSeq;
+    interrupt->Schedule(BudgetExpired, budgetSeq,
+		thread->budget - thread->used, SchedulerInt);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Charge
+// 	Count CPU time used by a periodic thread against its budget.
+//----------------------------------------------------------------------
+
+void
+EDFScheduler::Charge(Thread *thread, int ticks)
+{
+    if (thread->period > 0)
+	thread->used += ticks;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::PriorityQueue
+// 	Non-periodic threads wait in the background queue, by priority;
+//	periodic ones are kept by deadline, not priority.
+//----------------------------------------------------------------------
+
+RunQueue *
+EDFScheduler::PriorityQueue(Thread *thread)
+{
+    return (thread->period == 0) ? background : NULL;
+}
+
+//----------------------------------------------------------------------
+// EDFScheduler::Print
+// 	Print the ready threads, periodic ones first.
+//----------------------------------------------------------------------
+
+void
+EDFScheduler::Print()
+{
+    printf("num:%d utilization:%d/%d\n", deadlines->NumInTree()
+		+ background->NumInQueue(), utilization, FullUtilization);
+    printf("\nReady periodic threads:\n");
+    deadlines->Mapcar((VoidFunctionPtr) ThreadPrint);
+    printf("\nReady other threads:\n");
+    background->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
@@ -0,0 +1,59 @@
+// edfsched.h 
+//	Data structures for earliest-deadline-first real-time scheduling.
+//
+//	A thread becomes periodic by asking for a period and a budget
+//	(Thread::SetPeriodic): every "period" ticks it is released to do
+//	a job of at most "budget" ticks of CPU, which must be done by the
+//	end of the period (its deadline).  Between jobs it waits in
+//	Thread::WaitForNextPeriod.
+//
+//	Admission control only accepts a thread if the total utilization
+//	(sum of budget/period) stays at most 1, in which case EDF meets
+//	every deadline as long as threads keep to their budgets.  A
+//	thread that uses up its budget is throttled -- taken off the CPU
+//	until its next period -- so that it can't make others miss.
+//
+//	The ready periodic thread with the earliest deadline always runs;
+//	other threads only run when no periodic thread is ready, in
+//	priority order.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EDFSCHED_H
+#define EDFSCHED_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "runqueue.h"
+#include "avltree.h"
+
+#define FullUtilization	1000	// utilization is kept in thousandths
+
+class EDFScheduler : public Scheduler {
+  public:
+    EDFScheduler();			// initialize empty queues
+    ~EDFScheduler();
+
+    void Print();			// print the ready threads
+    bool IsEmpty() { return (deadlines->IsEmpty() && background->IsEmpty()); }
+
+    bool AdmitPeriodic(Thread* thread, int period, int budget);
+    void EndPeriodic(Thread* thread);
+    void WaitForNextPeriod(Thread* thread);
+
+  protected:
+    void Enqueue(Thread* thread);	// queue thread, or throttle it
+    Thread* Dequeue();			// earliest deadline first
+    void Charge(Thread* thread, int ticks);	// count against budget
+    RunQueue* PriorityQueue(Thread* thread);	// background, if
+						// not periodic
+
+  private:
+    AVLTree *deadlines;			// ready periodic threads, by deadline
+    RunQueue *background;		// ready non-periodic threads
+    int utilization;			// admitted so far, in thousandths
+};
+
+#endif // EDFSCHED_H
@@ -0,0 +1,124 @@
+// fairsched.cc 
+//	Routines for the "completely fair" scheduling policy.  See
+//	fairsched.h for a description.
+//
+//	A thread that has been blocked for a long time would otherwise
+//	come back with a very small virtual runtime, and hog the CPU
+//	until it caught up.  So when a thread becomes ready, its virtual
+//	runtime is moved up to at least that of the threads that have
+//	been running; this also gives new threads a fair starting point.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "fairsched.h"
+#include "system.h"
+
+// Weight of each priority, 0 (highest) to 10 (lowest).  Each step
+// is about a 1.25x difference in CPU share.
+static int priorityWeight[NumPriorities] = {
+    3121, 2501, 1991, 1586, 1277, 1024, 820, 655, 526, 423, 335
+};
+
+//----------------------------------------------------------------------
+// FairScheduler::FairScheduler
+// 	Initialize the tree of ready threads to empty.
+//----------------------------------------------------------------------
+
+FairScheduler::FairScheduler()
+{
+    tree = new AVLTree;
+    minVruntime = 0;
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::~FairScheduler
+// 	De-allocate the tree of ready threads.
+//----------------------------------------------------------------------
+
+FairScheduler::~FairScheduler()
+{
+    delete tree;
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::Weight
+// 	Return the weight of a priority level; a thread's share of the
+//	CPU is its weight over the sum of the weights of ready threads.
+//----------------------------------------------------------------------
+
+int
+FairScheduler::Weight(int priority)
+{
+    ASSERT((priority >= HighestPriority) && (priority <= LowestPriority));
+    return priorityWeight[priority];
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::Enqueue
+// 	Put a ready thread in the tree, in order of virtual runtime.
+//	Threads that weren't running start no earlier than minVruntime.
+//
+//	"thread" is the thread to put away.
+//----------------------------------------------------------------------
+
+void
+FairScheduler::Enqueue(Thread *thread)
+{
+    if (thread != currentThread && thread->vruntime < minVruntime)
+	thread->vruntime = minVruntime;
+    tree->Insert((void *)thread, thread->vruntime, thread->getTid());
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::Dequeue
+// 	Take the thread with the least virtual runtime out of the tree,
+//	NULL if there isn't one.
+//----------------------------------------------------------------------
+
+Thread *
+FairScheduler::Dequeue()
+{
+    int vruntime;
+    Thread *thread = (Thread *)tree->RemoveMin(&vruntime);
+
+    if (thread != NULL && vruntime > minVruntime)
+	minVruntime = vruntime;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::Charge
+// 	Advance a thread's virtual runtime by the CPU time it has used,
+//	scaled by its weight: heavier threads' clocks run slower.  What
+//	the division leaves over is carried to the next charge, so that
+//	a heavy thread that runs a few ticks at a time still pays.
+//
+//	"thread" is the thread that ran.
+//	"ticks" is how long it ran for.
+//----------------------------------------------------------------------
+
+void
+FairScheduler::Charge(Thread *thread, int ticks)
+{
+    int weight = Weight(thread->getPri());
+    int scaled = ticks * NiceZeroWeight + thread->vruntimeLeft;
+
+    thread->vruntime += scaled / weight;
+    thread->vruntimeLeft = scaled % weight;
+}
+
+//----------------------------------------------------------------------
+// FairScheduler::Print
+// 	Print the ready threads, least virtual runtime first.
+//----------------------------------------------------------------------
+
+void
+FairScheduler::Print()
+{
+    printf("num:%d min vruntime:%d\n", tree->NumInTree(), minVruntime);
+    printf("\nReady tree contents:\n");
+    tree->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
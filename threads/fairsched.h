@@ -0,0 +1,50 @@
+// fairsched.h 
+//	Data structures for a "completely fair" scheduling policy.
+//
+//	Each thread accumulates virtual runtime: the CPU time it has
+//	used, scaled down by a weight that depends on its priority.
+//	The ready thread with the least virtual runtime always runs
+//	next, so over time every thread gets a share of the CPU in
+//	proportion to its weight, and even the lowest priority thread
+//	is never starved.
+//
+//	Ready threads are kept in a balanced tree, sorted by virtual
+//	runtime (then thread id), so picking the next thread and putting
+//	one back are O(log n).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FAIRSCHED_H
+#define FAIRSCHED_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "avltree.h"
+
+#define NiceZeroWeight	1024	// weight whose virtual runtime is
+				// real time
+
+class FairScheduler : public Scheduler {
+  public:
+    FairScheduler();			// initialize an empty tree
+    ~FairScheduler();
+
+    void Print();			// print the ready threads
+    bool IsEmpty() { return tree->IsEmpty(); }
+
+    static int Weight(int priority);	// CPU share weight of a priority
+
+  protected:
+    void Enqueue(Thread* thread);	// put thread in the tree
+    Thread* Dequeue();			// take out the least vruntime
+    void Charge(Thread* thread, int ticks);	// advance its vruntime
+
+  private:
+    AVLTree *tree;			// ready threads, by vruntime
+    int minVruntime;			// never decreasing floor for the
+					// vruntime of threads becoming ready
+};
+
+#endif // FAIRSCHED_H
@@ -17,6 +17,52 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "system.h"
+
+// ListElements are allocated and freed on every list operation, so
+// instead of going back to the heap, freed elements are kept on a
+// free list (chained through "next") and handed out again.
+static ListElement *freeElements = NULL;
+
+//----------------------------------------------------------------------
+// ListElement::operator new
+// 	Allocate storage for a list element, from the free list if
+//	there is anything on it, otherwise from the heap.
+//----------------------------------------------------------------------
+
+void *
+ListElement::operator new(size_t size)
+{
+    ListElement *element;
+
+    ASSERT(size == sizeof(ListElement));
+    if (freeElements != NULL) {
+	element = freeElements;
+	freeElements = element->next;
+	if (stats != NULL)
+	    stats->numListElementReuses++;
+    } else {
+	element = (ListElement *) ::operator new(size);
+	if (stats != NULL)
+	    stats->numListElementAllocs++;
+    }
+    return element;
+}
+
+//----------------------------------------------------------------------
+// ListElement::operator delete
+// 	Put a list element's storage on the free list.  It is never
+//	given back to the heap.
+//----------------------------------------------------------------------
+
+void
+ListElement::operator delete(void *p)
+{
+    ListElement *element = (ListElement *) p;
+
+    element->next = freeElements;
+    freeElements = element;
+}
 
 //----------------------------------------------------------------------
 // ListElement::ListElement
@@ -8,8 +8,12 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sp <policy>
+//		-cpus <# of processors> -lp -tr <traceflags> -bench <name>
+//		-rec <log> -rep <log>
+//		-s -pc <ticks> -cache <size,assoc,line> -mp <ticks>
+//		-x <nachos file> -cr <checkpoint>
+//		-c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
 //              -n <network reliability> -m <machine id>
@@ -18,11 +22,34 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sp selects the scheduling policy: "priority" (the default),
+//	"fair", "stride", "lottery" or "edf"
+//    -cpus simulates a multiprocessor (priority scheduling only);
+//	user programs run on one host thread per CPU (see machine/cpu.h)
+//    -lp profiles contention on semaphores, locks and conditions, and
+//	prints the worst ones when Nachos halts
+//    -tr records the trace points with these flags (same as for -d) in
+//	a ring buffer, written to nachos.trace at the end; decode it
+//	with bin/tracedump
+//    -bench times kernel data structures on the host, running the
+//	benchmarks whose names start with <name> ("all" for all of them)
+//    -rec records the random numbers, interrupts and console and
+//	network input of the run in <log>
+//    -rep replays them from <log>, reporting where the run first
+//	differs from the recorded one; give the same other flags as
+//	when it was recorded (see machine/replay.h)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
+//    -pc samples the PC of user programs every <ticks>, and prints
+//	their busiest procedures when they exit (see userprog/pcprof.h)
+//    -cache puts a cache of <size> bytes, <assoc>-way set associative,
+//	with <line> byte lines, in front of memory; add ",wt" for
+//	write-through, ",split" for separate instruction and data caches
+//    -mp stalls the CPU for <ticks> on each cache miss
 //    -x runs a user program
+//    -cr resumes a user program from a checkpoint file
 //    -c tests the console
 //
 //  FILESYS
@@ -52,6 +79,7 @@
 
 #include "utility.h"
 #include "system.h"
+#include "bench.h"
 
 #ifdef THREADS
 extern int testnum;
@@ -62,6 +90,7 @@ extern int testnum;
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile, char *path);
 extern void Print(char *file, char *path), PerformanceTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out);
+extern void RestoreProcess(char *checkpoint);
 extern void MailTest(int networkID);
 
 extern void UserThreadTest(void);
@@ -88,6 +117,12 @@ main(int argc, char **argv)
 
     DEBUG('t', "Entering main");
     (void) Initialize(argc, argv);
+
+    for (int i = 1; i < argc - 1; i++)
+	if (!strcmp(argv[i], "-bench")) {	// time data structures
+	    RunBenchmarks(argv[i + 1]);
+	    interrupt->Halt();
+	}
     
 #ifdef THREADS
     for (argc--, argv++; argc > 0; argc -= argCount, argv += argCount) {
@@ -122,6 +157,11 @@ main(int argc, char **argv)
             StartProcess(*(argv + 1));
             argCount = 2;
 		} 
+		else if (!strcmp(*argv, "-cr")) {	// resume from a checkpoint
+			ASSERT(argc > 1);
+			RestoreProcess(*(argv + 1));
+			argCount = 2;
+		}
 		else if (!strcmp(*argv, "-c")) {      // test the console
 			if (argc == 1){
 				ConsoleTest(NULL, NULL);
@@ -0,0 +1,164 @@
+// runqueue.cc 
+//	Routines to manage the queue of threads that are ready to run.
+//	See runqueue.h for a description.
+//
+//	The bitmap is ordered so that the lowest set bit is the highest
+//	priority level, which makes finding the next thread to run a
+//	single find-first-set.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "runqueue.h"
+
+//----------------------------------------------------------------------
+// RunQueue::RunQueue
+// 	Initialize a run queue, with nothing on it.
+//----------------------------------------------------------------------
+
+RunQueue::RunQueue()
+{
+    for (int i = 0; i < NumPriorities; i++)
+	queue[i] = new List;
+    levels = 0;
+    numInQueue = 0;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::~RunQueue
+// 	De-allocate the per-priority lists.
+//----------------------------------------------------------------------
+
+RunQueue::~RunQueue()
+{
+    for (int i = 0; i < NumPriorities; i++)
+	delete queue[i];
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Append
+// 	Put a thread at the end of the list for its priority.
+//
+//	"thread" is the thread that has become ready.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Append(Thread *thread)
+{
+    int pri = thread->getPri();
+
+    ASSERT((pri >= HighestPriority) && (pri <= LowestPriority));
+    queue[pri]->Append((void *)thread);
+    levels |= (1 << pri);
+    numInQueue++;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Remove
+// 	Take the first thread off the highest priority non-empty list.
+//	Return NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::Remove()
+{
+    Thread *thread;
+    int pri;
+
+    if (levels == 0)
+	return NULL;
+    pri = ffs(levels) - 1;		// lowest set bit is the best level
+    thread = (Thread *)queue[pri]->Remove();
+    if (queue[pri]->IsEmpty())
+	levels &= ~(1 << pri);
+    numInQueue--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Remove
+// 	Take a particular thread off the queue, for instance because its
+//	priority is about to change.  Return FALSE if it wasn't there.
+//
+//	This walks the list for the thread's current priority, so it
+//	isn't constant time; it is only used off the fast path.
+//
+//	"thread" is the thread to take off.
+//----------------------------------------------------------------------
+
+bool
+RunQueue::Remove(Thread *thread)
+{
+    int pri = thread->getPri();
+    List *rest = new List;
+    Thread *t;
+    bool found = FALSE;
+
+    while ((t = (Thread *)queue[pri]->Remove()) != NULL) {
+	if (t == thread && !found)
+	    found = TRUE;
+	else
+	    rest->Append((void *)t);
+    }
+    delete queue[pri];
+    queue[pri] = rest;
+    if (rest->IsEmpty())
+	levels &= ~(1 << pri);
+    if (found)
+	numInQueue--;
+    return found;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Steal
+// 	Take off the first thread, highest priority first, that another
+//	processor may take over: one without an affinity for a particular
+//	processor, or with an affinity for the one stealing it.  Return
+//	NULL if there is none.
+//
+//	Like Remove(thread), this walks the lists.
+//
+//	"cpuId" is the processor that wants the thread.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::Steal(int cpuId)
+{
+    Thread *t, *stolen = NULL;
+    int pri, n;
+
+    for (pri = 0; pri < NumPriorities && stolen == NULL; pri++) {
+	if (!(levels & (1 << pri)))
+	    continue;
+	//转一圈，取出第一个可以迁移的线程，其余保持原来顺序
+	for (n = queue[pri]->NumInList(); n > 0; n--) {
+	    t = (Thread *)queue[pri]->Remove();
+	    if (stolen == NULL && (t->affinity < 0 || t->affinity == cpuId))
+		stolen = t;
+	    else
+		queue[pri]->Append((void *)t);
+	}
+	if (queue[pri]->IsEmpty())
+	    levels &= ~(1 << pri);
+    }
+    if (stolen != NULL)
+	numInQueue--;
+    return stolen;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Mapcar
+// 	Apply a function to each thread on the queue, highest priority
+//	first.
+//
+//	"func" is the procedure to apply to each thread.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < NumPriorities; i++)
+	queue[i]->Mapcar(func);
+}
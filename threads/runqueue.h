@@ -0,0 +1,48 @@
+// runqueue.h 
+//	Data structures for the queue of threads that are ready to run.
+//
+//	Threads are kept on one FIFO list per priority level, along with
+//	a bitmap of the levels that have something on them, so that both
+//	putting a thread on the queue and taking off the highest priority
+//	one take constant time, however many threads are ready.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RUNQUEUE_H
+#define RUNQUEUE_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+// The following class defines a run queue -- threads ordered first by
+// priority (0 is highest), then in the order they became ready.
+
+class RunQueue {
+  public:
+    RunQueue();			// initialize an empty queue
+    ~RunQueue();		// de-allocate the per-priority lists
+
+    void Append(Thread *thread);	// put thread behind the others
+					// of the same priority
+    Thread *Remove();			// take off the first thread of
+					// the highest priority, or NULL
+    bool Remove(Thread *thread);	// take thread off, wherever it is
+    Thread *Steal(int cpuId);		// take off the first thread that
+					// may move to processor cpuId
+
+    bool IsEmpty() { return (levels == 0); }
+    int NumInQueue() { return numInQueue; }
+    void Mapcar(VoidFunctionPtr func);	// apply func to every thread,
+					// highest priority first
+
+  private:
+    List *queue[NumPriorities];		// ready threads, one list per level
+    unsigned int levels;		// bit i is set iff queue[i] is
+					// not empty
+    int numInQueue;			// total number of ready threads
+};
+
+#endif // RUNQUEUE_H
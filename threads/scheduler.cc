@@ -22,6 +22,24 @@
 #include "scheduler.h"
 #include "system.h"
 
+static int sliceSeq = 0;	// the current time slice, on a multiprocessor
+
+//----------------------------------------------------------------------
+// SliceExpired
+// 	On a multiprocessor whose CPUs take turns, the time slice of the
+//	current CPU is over: yield, so that the CPU furthest behind gets
+//	to run.  Slices that ended early (the thread blocked) are ignored.
+//
+//	"seq" is the time slice the alarm was set for.
+//----------------------------------------------------------------------
+
+static void
+SliceExpired(int seq)
+{
+    if (seq == sliceSeq && interrupt->getStatus() != IdleMode)
+	interrupt->YieldOnReturn();
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
@@ -29,7 +47,8 @@
 
 Scheduler::Scheduler()
 { 
-    readyList = new List; 
+    for (int i = 0; i < numCPUs; i++)
+	readyList[i] = new RunQueue; 
     suspendedList = new List;
 } 
 
@@ -40,7 +59,8 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
+    for (int i = 0; i < numCPUs; i++)
+	delete readyList[i]; 
     delete suspendedList;
 } 
 
@@ -58,8 +78,14 @@ Scheduler::ReadyToRun (Thread *thread)
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
     thread->setStatus(READY);
-    //按照优先级插入就绪队列
-    readyList->SortedInsert((void *)thread, thread->getPri());
+    thread->readyTime = stats->totalTicks;
+    //正在运行的线程让出CPU，先结算它用掉的时间
+    if (thread == currentThread)
+	Account(thread);
+    Enqueue(thread);
+    //有线程可以切换了，重新打开时钟
+    if (timer != NULL)
+	timer->Start();
 }
 
 //----------------------------------------------------------------------
@@ -73,7 +99,278 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
-    return (Thread *)readyList->Remove();
+    return Dequeue();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Enqueue
+// 	Put a ready thread on the ready list, behind the other threads
+//	of the same priority.
+//
+//	"thread" is the thread to put away.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Enqueue (Thread *thread)
+{
+    CPU *cpu = thread->cpu;
+
+    //有亲和性的线程放到指定的CPU上；其余的第一次就绪时放到最空闲的
+    //CPU上，以后留在该CPU，除非被别的CPU偷走
+    if (thread->affinity >= 0 && thread->affinity < numCPUs)
+	thread->cpu = cpus[thread->affinity];
+    else if (thread->cpu == NULL)
+	thread->cpu = LeastLoaded();
+    if (cpu != NULL && cpu != thread->cpu)
+	stats->numMigrations++;
+    //按照优先级插入就绪队列，同一优先级先来先服务
+    readyList[thread->cpu->id]->Append(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dequeue
+// 	Take the highest priority thread off the ready list, NULL if
+//	there isn't one.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Dequeue ()
+{
+    CPU *best = NULL;
+    Thread *thread;
+    int i, len;
+
+    if (numCPUs == 1)
+	return readyList[0]->Remove();
+    if (IsEmpty())
+	return NULL;
+    for (i = 0; i < numCPUs; i++) {
+	len = readyList[i]->NumInQueue();
+	stats->runQueueSamples++;
+	stats->runQueueTotal += len;
+	if (len > stats->runQueueMax)
+	    stats->runQueueMax = len;
+    }
+
+    //时间最落后的CPU先运行；它没有就绪线程时，从别的CPU偷一个。
+    //宿主线程正在运行用户程序的CPU是忙的，不参加
+    for (i = 0; i < numCPUs; i++) {
+	if (cpus[i]->userThread != NULL)
+	    continue;
+	if (best == NULL || CPUTime(cpus[i]) < CPUTime(best))
+	    best = cpus[i];
+    }
+    if (best == NULL)
+	return NULL;
+    if (readyList[best->id]->IsEmpty()) {
+	thread = Steal(best);
+	if (thread != NULL)
+	    return thread;
+	//都不能迁移，只好由有就绪线程的空闲CPU中最落后的一个运行
+	best = NULL;
+	for (i = 0; i < numCPUs; i++) {
+	    if (readyList[i]->IsEmpty() || cpus[i]->userThread != NULL)
+		continue;
+	    if (best == NULL || CPUTime(cpus[i]) < CPUTime(best))
+		best = cpus[i];
+	}
+	if (best == NULL)
+	    return NULL;
+    }
+    return readyList[best->id]->Remove();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Steal
+// 	An idle processor takes a thread from the run queue of another
+//	one, trying the processor with the most ready threads first.
+//	Threads with an affinity for some other processor are left
+//	alone.  Return NULL if nothing could be taken.
+//
+//	"thief" is the idle processor.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Steal (CPU *thief)
+{
+    bool tried[MaxCPUs];
+    CPU *victim;
+    Thread *thread;
+    int i;
+
+    for (i = 0; i < numCPUs; i++)
+	tried[i] = FALSE;
+    for (;;) {
+	victim = NULL;
+	for (i = 0; i < numCPUs; i++) {
+	    if (tried[i] || readyList[i]->IsEmpty())
+		continue;
+	    if (victim == NULL || readyList[i]->NumInQueue()
+				  > readyList[victim->id]->NumInQueue())
+		victim = cpus[i];
+	}
+	if (victim == NULL)
+	    return NULL;
+	tried[victim->id] = TRUE;
+	thread = readyList[victim->id]->Steal(thief->id);
+	if (thread != NULL) {
+	    DEBUG('t', "CPU %d steals \"%s\" from CPU %d\n", thief->id,
+		thread->getName(), victim->id);
+	    thread->cpu = thief;
+	    thief->numSteals++;
+	    stats->numSteals++;
+	    stats->numMigrations++;
+	    return thread;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IsEmpty
+// 	Return TRUE if no thread is ready to run, on any CPU.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IsEmpty ()
+{
+    for (int i = 0; i < numCPUs; i++)
+	if (!readyList[i]->IsEmpty())
+	    return FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::LeastLoaded
+// 	Return the CPU with the fewest threads on it, counting the one
+//	running on the current CPU, and those running user code on the
+//	host threads.
+//----------------------------------------------------------------------
+
+CPU *
+Scheduler::LeastLoaded ()
+{
+    CPU *best = NULL;
+    int bestLoad = 0, load, i;
+
+    for (i = 0; i < numCPUs; i++) {
+	load = readyList[i]->NumInQueue() + ((cpus[i] == currentCPU) ? 1 : 0)
+		+ ((cpus[i]->userThread != NULL) ? 1 : 0);
+	if (best == NULL || load < bestLoad) {
+	    best = cpus[i];
+	    bestLoad = load;
+	}
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCPU
+// 	On a multiprocessor, make the CPU that nextThread belongs to the
+//	current one: save the clock of the CPU we are leaving, and
+//	switch to the clock and Machine of the new one.  The new CPU's
+//	clock moves up to when nextThread became ready, if it was idle
+//	until then.
+//
+//	Also flush the TLB if it holds entries for a different address
+//	space, or if another CPU asked us to, and, if the CPUs take
+//	turns, start a time slice.
+//
+//	"nextThread" is the thread about to run.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCPU (Thread *nextThread)
+{
+    CPU *cpu = nextThread->cpu;
+    int start;
+
+    if (cpu != currentCPU) {
+	currentCPU->clock = stats->totalTicks;
+	start = (nextThread->readyTime > cpu->clock) ? nextThread->readyTime
+						     : cpu->clock;
+	cpu->idleTicks += start - cpu->clock;
+	cpu->clock = start;
+	stats->totalTicks = start;
+	currentCPU = cpu;
+#ifdef USER_PROGRAM
+	machine = cpu->machine;
+#endif
+    }
+#ifdef USE_TLB
+    if (cpu->shootdown
+	    || (nextThread->space != NULL && nextThread->space != cpu->tlbSpace)) {
+	cpu->FlushTLB();
+	cpu->tlbSpace = nextThread->space;
+	cpu->shootdown = FALSE;
+    }
+#endif
+    cpu->numDispatches++;
+    if (!hostCPUs)
+	interrupt->Schedule(SliceExpired, ++sliceSeq, TimerTicks, SchedulerInt);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ChangePriority
+// 	Change the priority of a thread.  If it is ready, on a queue
+//	kept in priority order, it has to be moved to the place for its
+//	new priority.  Policies that don't order by priority (fair,
+//	stride, lottery, and EDF for periodic threads) leave it where
+//	it is.
+//
+//	"thread" is the thread whose priority changes.
+//	"pri" is its new priority.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ChangePriority (Thread *thread, int pri)
+{
+    RunQueue *queue = NULL;
+
+    if (thread->getStatus() == READY) {
+	queue = PriorityQueue(thread);
+	if (queue != NULL && !queue->Remove(thread))
+	    queue = NULL;
+    }
+    thread->setPri(pri);
+    if (queue != NULL)
+	queue->Append(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PriorityQueue
+// 	Return the run queue of a ready thread's CPU, which is where
+//	Enqueue put it.
+//
+//	"thread" is a ready thread.
+//----------------------------------------------------------------------
+
+RunQueue *
+Scheduler::PriorityQueue (Thread *thread)
+{
+    return (thread->cpu != NULL) ? readyList[thread->cpu->id] : NULL;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Account
+// 	Charge a thread for the CPU time it has used since it was last
+//	dispatched (or last charged), and start counting again from now.
+//	Time the machine spent idle in between isn't charged.
+//
+//	"thread" is the running thread.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Account (Thread *thread)
+{
+    int ticks = stats->totalTicks - thread->lastDispatch
+		- (stats->idleTicks - thread->idleAtDispatch);
+
+    if (ticks > 0) {
+	thread->cpuTicks += ticks;
+	Charge(thread, ticks);
+    }
+    thread->lastDispatch = stats->totalTicks;
+    thread->idleAtDispatch = stats->idleTicks;
 }
 
 //----------------------------------------------------------------------
@@ -94,10 +391,11 @@ void
 Scheduler::Run (Thread *nextThread)
 {
     Thread *oldThread = currentThread;
-    int i,j;
     
 #ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
+    if (currentThread->space != NULL	// if this thread is a user program,
+	    && currentCPU->userThread != currentThread) {
+					// not running on a host thread,
         currentThread->SaveUserState(); // save the user's CPU registers
         currentThread->space->SaveState();
         //清空占用的内存
@@ -117,21 +415,32 @@ Scheduler::Run (Thread *nextThread)
         //         currentThread->space->pageTable[i].valid = FALSE;
         //     }
         // }
-        //清空TLB
-        for(i =0; i < TLBSize; i++){
-            machine->tlb[i].valid = FALSE;
+        //清空TLB（多处理器时由SwitchCPU按地址空间决定是否清空）
+        if (numCPUs == 1 && machine->tlb != NULL) {
+            for(int i =0; i < TLBSize; i++){
+                machine->tlb[i].valid = FALSE;
+            }
         }
     }
 #endif
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
+    Account(oldThread);			    // charge it for its time slice
+    TRACE('t', TraceStop, oldThread->getTid(), 0, 0);
+    if (numCPUs > 1)
+	SwitchCPU(nextThread);		    // move to nextThread's CPU
+    nextThread->lastDispatch = stats->totalTicks;
+    nextThread->idleAtDispatch = stats->idleTicks;
+    nextThread->AddUsage(ResWaitTicks, stats->totalTicks - nextThread->readyTime);
+    nextThread->AddUsage(ResContextSwitches, 1);
 
     currentThread = nextThread;		    // switch to the next thread
     currentThread->setStatus(RUNNING);      // nextThread is now running
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
+    TRACE('t', TraceSwitch, nextThread->getTid(), oldThread->getTid(), 0);
     
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
@@ -146,15 +455,7 @@ Scheduler::Run (Thread *nextThread)
     // we need to delete its carcass.  Note we cannot delete the thread
     // before now (for example, in Thread::Finish()), because up to this
     // point, we were still running on the old thread's stack!
-    if (threadToBeDestroyed != NULL && threadToBeDestroyed->fatherThread != NULL) {
-        //删除其父线程中子线程数组对应项
-        Thread *fthread = threadToBeDestroyed->fatherThread;
-        for(i = 0; i < MaxChildThreadNum; i++){
-            if(fthread->childThread[i] == threadToBeDestroyed){
-                printf("[scheduler]Father thread (%s) is deleting his child (%s)\n",fthread->getName(),threadToBeDestroyed->getName());
-                fthread->childThread[i] = NULL;
-            }
-        }
+    if (threadToBeDestroyed != NULL) {
         delete threadToBeDestroyed;
 	    threadToBeDestroyed = NULL;
     }
@@ -166,7 +467,6 @@ Scheduler::Run (Thread *nextThread)
 	    currentThread->space->RestoreState();
     }
 #endif
-    printf("[shceduler]Switching from thread (%s) to thread (%s)\n",oldThread->getName(), nextThread->getName());
 }
 
 //----------------------------------------------------------------------
@@ -177,7 +477,11 @@ Scheduler::Run (Thread *nextThread)
 void
 Scheduler::Print()
 {
-    printf("num:%d\n",readyList->NumInList());
-    printf("\nReady list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    for (int i = 0; i < numCPUs; i++) {
+        if (numCPUs > 1)
+            printf("CPU %d, time %d\n", i, CPUTime(cpus[i]));
+        printf("num:%d\n",readyList[i]->NumInQueue());
+        printf("\nReady list contents:\n");
+        readyList[i]->Mapcar((VoidFunctionPtr) ThreadPrint);
+    }
 }
@@ -12,25 +12,70 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "runqueue.h"
+#include "cpu.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// This class schedules by strict priority, round-robin within a
+// priority.  Other scheduling policies are subclasses, which replace
+// how the ready threads are kept (Enqueue, Dequeue, IsEmpty, Print,
+// PriorityQueue) and how CPU time is charged to a thread (Charge).
+//
+// With more than one simulated CPU (see machine/cpu.h), each CPU has
+// its own run queue, and a thread stays on the CPU it was first put
+// on, or the one it has an affinity for.  The CPU that is furthest
+// behind in time runs next; if its queue is empty, it steals a thread
+// from the busiest queue.  Run switches to that CPU's clock and
+// Machine.  A CPU whose host thread is running user code is busy, and
+// runs nothing else until the kernel has it back.
 
 class Scheduler {
   public:
     Scheduler();			// Initialize list of ready threads 
-    ~Scheduler();			// De-allocate ready list
+    virtual ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
-    void Print();			// Print contents of ready list
+    virtual void Print();		// Print contents of ready list
+    virtual bool IsEmpty();		// no thread ready to run?
+    void ChangePriority(Thread* thread, int pri);
+					// give thread a new priority
     List *suspendedList;  //挂起的线程队列
+
+    // Periodic real-time threads; only EDFScheduler supports them
+    virtual bool AdmitPeriodic(Thread* thread, int period, int budget)
+	{ return FALSE; }		// make thread periodic, if it fits
+    virtual void EndPeriodic(Thread* thread) {}
+					// thread is no longer periodic
+    virtual void WaitForNextPeriod(Thread* thread) { ASSERT(FALSE); }
+					// end of this period's job
+
+  protected:
+    virtual void Enqueue(Thread* thread);	// put a ready thread away
+    virtual Thread* Dequeue();			// pick the next to run
+    virtual void Charge(Thread* thread, int ticks) {}
+					// thread has just used "ticks"
+					// of CPU time
+    virtual RunQueue* PriorityQueue(Thread* thread);
+					// the queue that orders thread by
+					// priority, or NULL if none does
+    void Account(Thread* thread);	// charge thread for the time it
+					// has run since it was dispatched
+
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-        // but not running
+    void SwitchCPU(Thread* nextThread);	// make nextThread's CPU the
+					// current one
+    CPU* LeastLoaded();			// CPU with the fewest threads
+    Thread* Steal(CPU* thief);		// take a thread from the busiest
+					// CPU that has one thief may run
+
+    RunQueue *readyList[MaxCPUs];  	// queue of threads that are ready
+        // to run, but not running, by priority; one per CPU
     
 };
 
@@ -0,0 +1,189 @@
+// stridesched.cc 
+//	Routines for proportional-share scheduling.  See stridesched.h
+//	for a description.
+//
+//	Tickets can change while a thread is ready, as donations come
+//	and go, so neither policy caches them: the stride scheduler
+//	reads them when it charges a thread, and the lottery counts
+//	them afresh at each draw.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "stridesched.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// StrideScheduler::StrideScheduler
+// 	Initialize the tree of ready threads to empty.
+//----------------------------------------------------------------------
+
+StrideScheduler::StrideScheduler()
+{
+    tree = new AVLTree;
+    minPass = 0;
+}
+
+//----------------------------------------------------------------------
+// StrideScheduler::~StrideScheduler
+// 	De-allocate the tree of ready threads.
+//----------------------------------------------------------------------
+
+StrideScheduler::~StrideScheduler()
+{
+    delete tree;
+}
+
+//----------------------------------------------------------------------
+// StrideScheduler::Enqueue
+// 	Put a ready thread in the tree, in order of pass.  A thread that
+//	wasn't running can't have fallen behind the others while it was
+//	blocked, so its pass starts no earlier than minPass.
+//
+//	"thread" is the thread to put away.
+//----------------------------------------------------------------------
+
+void
+StrideScheduler::Enqueue(Thread *thread)
+{
+    if (thread != currentThread && thread->pass < minPass)
+	thread->pass = minPass;
+    tree->Insert((void *)thread, thread->pass, thread->getTid());
+}
+
+//----------------------------------------------------------------------
+// StrideScheduler::Dequeue
+// 	Take the thread with the smallest pass out of the tree, NULL if
+//	there isn't one.
+//----------------------------------------------------------------------
+
+Thread *
+StrideScheduler::Dequeue()
+{
+    int pass;
+    Thread *thread = (Thread *)tree->RemoveMin(&pass);
+
+    if (thread != NULL && pass > minPass)
+	minPass = pass;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// StrideScheduler::Charge
+// 	Advance a thread's pass by the CPU time it has used, divided by
+//	the tickets it holds (its own, plus any lent to it).  What the
+//	division leaves over is carried to the next charge; otherwise a
+//	thread with more than StrideScale tickets, charged a few ticks
+//	at a time, would never advance, and would starve the others.
+//
+//	"thread" is the thread that ran.
+//	"ticks" is how long it ran for.
+//----------------------------------------------------------------------
+
+void
+StrideScheduler::Charge(Thread *thread, int ticks)
+{
+    int tickets = thread->Tickets();
+    int scaled = ticks * StrideScale + thread->passLeft;
+
+    thread->pass += scaled / tickets;
+    thread->passLeft = scaled % tickets;
+}
+
+//----------------------------------------------------------------------
+// StrideScheduler::Print
+// 	Print the ready threads, smallest pass first.
+//----------------------------------------------------------------------
+
+void
+StrideScheduler::Print()
+{
+    printf("num:%d min pass:%d\n", tree->NumInTree(), minPass);
+    printf("\nReady tree contents:\n");
+    tree->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// LotteryScheduler::LotteryScheduler
+// 	Initialize the list of ready threads to empty.
+//----------------------------------------------------------------------
+
+LotteryScheduler::LotteryScheduler()
+{
+    readyThreads = new List;
+}
+
+//----------------------------------------------------------------------
+// LotteryScheduler::~LotteryScheduler
+// 	De-allocate the list of ready threads.
+//----------------------------------------------------------------------
+
+LotteryScheduler::~LotteryScheduler()
+{
+    delete readyThreads;
+}
+
+//----------------------------------------------------------------------
+// LotteryScheduler::Enqueue
+// 	Put a ready thread on the list.
+//
+//	"thread" is the thread to put away.
+//----------------------------------------------------------------------
+
+void
+LotteryScheduler::Enqueue(Thread *thread)
+{
+    readyThreads->Append((void *)thread);
+}
+
+//----------------------------------------------------------------------
+// LotteryScheduler::Dequeue
+// 	Draw a ticket at random from those held by the ready threads,
+//	and take the winner off the list.  NULL if no thread is ready.
+//
+//	The list is walked by rotating it: each thread is taken off the
+//	front and put back at the end, except the winner.
+//----------------------------------------------------------------------
+
+Thread *
+LotteryScheduler::Dequeue()
+{
+    Thread *thread, *winner = NULL;
+    int n = readyThreads->NumInList();
+    int total = 0, draw, i;
+
+    if (n == 0)
+	return NULL;
+    for (i = 0; i < n; i++) {
+	thread = (Thread *)readyThreads->Remove();
+	total += thread->Tickets();
+	readyThreads->Append((void *)thread);
+    }
+    draw = Random() % total;
+    for (i = 0; i < n; i++) {
+	thread = (Thread *)readyThreads->Remove();
+	if (winner == NULL && draw < thread->Tickets())
+	    winner = thread;
+	else {
+	    draw -= thread->Tickets();
+	    readyThreads->Append((void *)thread);
+	}
+    }
+    ASSERT(winner != NULL);
+    return winner;
+}
+
+//----------------------------------------------------------------------
+// LotteryScheduler::Print
+// 	Print the ready threads.
+//----------------------------------------------------------------------
+
+void
+LotteryScheduler::Print()
+{
+    printf("num:%d\n", readyThreads->NumInList());
+    printf("\nReady list contents:\n");
+    readyThreads->Mapcar((VoidFunctionPtr) ThreadPrint);
+}
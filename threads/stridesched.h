@@ -0,0 +1,68 @@
+// stridesched.h 
+//	Data structures for proportional-share scheduling.
+//
+//	Each thread holds a number of tickets, and over time gets a share
+//	of the CPU in proportion to its tickets (see Thread::Tickets,
+//	which includes tickets lent to it by threads blocked on a lock it
+//	holds).  Two policies are provided:
+//
+//	StrideScheduler -- deterministic.  Each thread has a "pass" that
+//		advances by the CPU time it uses divided by its tickets;
+//		the ready thread with the smallest pass runs next.
+//
+//	LotteryScheduler -- randomized.  Each time a thread is needed,
+//		a ticket is drawn at random among the ready threads, and
+//		its holder runs.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STRIDESCHED_H
+#define STRIDESCHED_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "avltree.h"
+#include "list.h"
+
+#define StrideScale	DefaultTickets	// a thread holding the default
+					// number of tickets has its pass
+					// advance by one per tick
+
+class StrideScheduler : public Scheduler {
+  public:
+    StrideScheduler();			// initialize an empty tree
+    ~StrideScheduler();
+
+    void Print();			// print the ready threads
+    bool IsEmpty() { return tree->IsEmpty(); }
+
+  protected:
+    void Enqueue(Thread* thread);	// put thread in the tree
+    Thread* Dequeue();			// take out the smallest pass
+    void Charge(Thread* thread, int ticks);	// advance its pass
+
+  private:
+    AVLTree *tree;			// ready threads, by pass
+    int minPass;			// never decreasing floor for the
+					// pass of threads becoming ready
+};
+
+class LotteryScheduler : public Scheduler {
+  public:
+    LotteryScheduler();			// initialize an empty list
+    ~LotteryScheduler();
+
+    void Print();			// print the ready threads
+    bool IsEmpty() { return readyThreads->IsEmpty(); }
+
+  protected:
+    void Enqueue(Thread* thread);	// put thread on the list
+    Thread* Dequeue();			// hold a lottery
+
+  private:
+    List *readyThreads;			// ready threads, in no order
+};
+
+#endif // STRIDESCHED_H
@@ -32,13 +32,19 @@
 //
 //	"debugName" is an arbitrary name, useful for debugging.
 //	"initialValue" is the initial value of the semaphore.
+//	"profiled" is FALSE for semaphores that are part of a lock, which
+//		is profiled instead.
 //----------------------------------------------------------------------
 
-Semaphore::Semaphore(char* debugName, int initialValue)
+Semaphore::Semaphore(char* debugName, int initialValue, bool profiled)
 {
     name = debugName;
     value = initialValue;
     queue = new List;
+    if (synchProfiler != NULL && profiled)
+	profile = synchProfiler->Register(SemaphoreKind, debugName);
+    else
+	profile = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -66,6 +72,8 @@ void
 Semaphore::P()
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
+    int start = stats->totalTicks;
+    bool contended = (value <= 0);
     
     while (value <= 0) { 			// semaphore not available
 	    queue->Append((void *)currentThread);	// so go to sleep
@@ -73,6 +81,8 @@ Semaphore::P()
     } 
     value--; 					// semaphore available, 
 						// consume its value
+    if (profile != NULL)
+	profile->Acquired(stats->totalTicks - start, contended);
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
 }
@@ -103,21 +113,130 @@ Semaphore::V()
 // the test case in the network assignment won't work!
 
 //锁的实现
-Lock::Lock(char* debugName) {
+Lock::Lock(char* debugName, int ceilingPri) {
+    ASSERT(ceilingPri >= HighestPriority && ceilingPri <= NoCeiling);
     name = debugName;
-    mutex = new Semaphore("mutex", 1);
-    
+    ceiling = ceilingPri;
+    waiters = new List;
+    nextHeld = NULL;
+    mutex = new Semaphore("mutex", 1, FALSE);
+    heldThread = NULL;
+    donated = 0;
+    if (synchProfiler != NULL)
+	profile = synchProfiler->Register(LockKind, debugName);
+    else
+	profile = NULL;
+    acquiredAt = 0;
+}
+Lock::~Lock() {
+    delete waiters;
 }
-Lock::~Lock() {}
 
+//等待锁的线程把票借给持有者，拿到锁后收回；
+//其余等待者借出的票随锁转给新的持有者
 void Lock::Acquire() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int mine = 0;
+    int start = stats->totalTicks;
+    bool contended = (heldThread != NULL);
+    //有天花板的锁不能被优先级比天花板还高的线程使用
+    ASSERT(currentThread->basePri >= ceiling || ceiling == NoCeiling);
+    if(heldThread != NULL){
+        mine = currentThread->Tickets();
+        Donate(mine);
+        //等待期间持有者继承我们的优先级
+        currentThread->waitingOn = this;
+        waiters->Append((void *)currentThread);
+        heldThread->UpdatePriority();
+    }
     mutex->P();
+    if(contended){
+        waiters->Remove((void *)currentThread);
+        currentThread->waitingOn = NULL;
+    }
+    donated -= mine;
     heldThread = currentThread;
+    heldThread->donatedTickets += donated;
+    //记入持有的锁，继承其余等待者的优先级和天花板
+    nextHeld = heldThread->heldLocks;
+    heldThread->heldLocks = this;
+    heldThread->UpdatePriority();
+    acquiredAt = stats->totalTicks;
+    if(profile != NULL){
+        profile->Acquired(acquiredAt - start, contended);
+    }
+    interrupt->SetLevel(oldLevel);
 }
 
 void Lock::Release() {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *holder = heldThread;
+    int pri = 0;
+    Lock **l;
+    if(holder != NULL){
+        holder->donatedTickets -= donated;
+        if(profile != NULL){
+            profile->Released(stats->totalTicks - acquiredAt);
+        }
+        //从持有的锁中去掉，恢复原来的优先级（或其余锁继承的优先级）
+        for(l = &holder->heldLocks; *l != NULL; l = &(*l)->nextHeld){
+            if(*l == this){
+                *l = nextHeld;
+                break;
+            }
+        }
+        nextHeld = NULL;
+        pri = holder->getPri();
+    }
     heldThread = NULL;
     mutex->V();
+    if(holder != NULL){
+        holder->UpdatePriority();
+    }
+    interrupt->SetLevel(oldLevel);
+    //优先级降低了，让继承给我们优先级的线程先运行
+    //（在Condition::Wait中中断是关的，不能在这里让出CPU）
+    if(holder == currentThread && holder->getPri() > pri && oldLevel == IntOn){
+        currentThread->Yield();
+    }
+}
+
+//----------------------------------------------------------------------
+// Lock::InheritedPriority
+// 	Return the priority the holder of this lock must run at, at
+//	least: the best priority of the threads waiting for the lock, or
+//	the ceiling of the lock, whichever is better.
+//----------------------------------------------------------------------
+
+int Lock::InheritedPriority() {
+    int best = ceiling;
+    int n = waiters->NumInList();
+    Thread *t;
+    //转一圈，顺序不变
+    for(int i = 0; i < n; i++){
+        t = (Thread *)waiters->Remove();
+        if(t->getPri() < best){
+            best = t->getPri();
+        }
+        waiters->Append((void *)t);
+    }
+    return best;
+}
+
+//借出票：记在锁上，并立即加给当前持有者
+void Lock::Donate(int amount) {
+    donated += amount;
+    if(heldThread != NULL){
+        heldThread->donatedTickets += amount;
+    }
+}
+
+//收回借出的票
+void Lock::Revoke(int amount) {
+    donated -= amount;
+    if(heldThread != NULL){
+        heldThread->donatedTickets -= amount;
+    }
 }
 
 bool Lock::isHeldByCurrentThread(){
@@ -129,6 +248,10 @@ bool Lock::isHeldByCurrentThread(){
 Condition::Condition(char* debugName) {
     name = debugName;
     waitQueue = new List;
+    if (synchProfiler != NULL)
+	profile = synchProfiler->Register(ConditionKind, debugName);
+    else
+	profile = NULL;
 }
 Condition::~Condition() { 
     delete waitQueue;
@@ -136,9 +259,17 @@ Condition::~Condition() {
 void Condition::Wait(Lock* conditionLock) { 
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     conditionLock->Release();
+    //等待期间把票借给持有该锁的线程（要唤醒我们的一方必须持有它）
+    int mine = currentThread->Tickets();
+    conditionLock->Donate(mine);
     waitQueue->Append((Thread*)currentThread);
+    int start = stats->totalTicks;
     currentThread->Sleep();
     //唤醒后
+    if(profile != NULL){
+        profile->Acquired(stats->totalTicks - start, TRUE);
+    }
+    conditionLock->Revoke(mine);
     conditionLock->Acquire();
     interrupt->SetLevel(oldLevel);
 }
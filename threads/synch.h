@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "synchprof.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -38,7 +39,8 @@
 
 class Semaphore {
   public:
-    Semaphore(char* debugName, int initialValue);	// set initial value
+    Semaphore(char* debugName, int initialValue, bool profiled = TRUE);
+							// set initial value
     ~Semaphore();   					// de-allocate semaphore
     char* getName() { return name;}			// debugging assist
     
@@ -49,6 +51,7 @@ class Semaphore {
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
     List *queue;       // threads waiting in P() for the value to be > 0
+    SynchProfile *profile;	// contention record, NULL if not profiling
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -62,10 +65,20 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// To keep a low priority holder from being held up indefinitely by
+// medium priority threads while a high priority thread waits for the
+// lock, the holder inherits the priority of its best waiter, until it
+// releases the lock.  A lock may also have a priority ceiling: whoever
+// holds it runs at least at that priority, so that it can't be
+// preempted by any other thread that might want the lock.
+
+#define NoCeiling	(LowestPriority + 1)	// a lock without a ceiling
 
 class Lock {
   public:
-    Lock(char* debugName);  		// initialize lock to be FREE
+    Lock(char* debugName, int ceilingPri = NoCeiling);
+					// initialize lock to be FREE
     ~Lock();				// deallocate lock
     char* getName() { return name; }	// debugging assist
 
@@ -77,11 +90,24 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    void Donate(int amount);		// lend tickets to whoever holds
+    void Revoke(int amount);		// the lock, and take them back
+
+    Thread *Holder() { return heldThread; }
+    int InheritedPriority();		// priority the holder must run at
+
+    Lock *nextHeld;			// next lock held by the same thread
+
   private:
     char* name;				// for debugging
     // plus some other stuff you'll need to define
     Semaphore* mutex;  //利用信号量实现锁
     Thread* heldThread; //记录该锁由哪个线程持有，用于实现isHeldByCurrentThread
+    int donated;	//等待者借给持有者的票数
+    SynchProfile *profile;	// contention record, NULL if not profiling
+    int acquiredAt;	// when heldThread got the lock
+    List *waiters;	//等待该锁的线程，用于优先级继承
+    int ceiling;	//优先级天花板，NoCeiling表示没有
 };
 
 // The following class defines a "condition variable".  A condition
@@ -135,5 +161,6 @@ class Condition {
     char* name;
     // plus some other stuff you'll need to define
     List* waitQueue;  //等待队列
+    SynchProfile *profile;	// contention record, NULL if not profiling
 };
 #endif // SYNCH_H
@@ -0,0 +1,214 @@
+// synchprof.cc
+//	Routines to profile contention on synchronization objects.  See
+//	synchprof.h for what is recorded.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprof.h"
+#include "system.h"
+
+static char *kindNames[] = { "semaphore", "lock", "condition", "mixed" };
+
+//----------------------------------------------------------------------
+// SynchProfile::SynchProfile
+// 	Initialize a profile record, with nothing counted yet.
+//
+//	"k" is the kind of object the record is for.
+//	"debugName" is the name of the objects.
+//----------------------------------------------------------------------
+
+SynchProfile::SynchProfile(SynchKind k, char *debugName)
+{
+    kind = k;
+    strncpy(name, debugName, sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    acquisitions = contended = 0;
+    totalWait = maxWait = 0;
+    releases = totalHold = maxHold = 0;
+    numWaiters = 0;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Acquired
+// 	Count one P, Acquire or Wait by the current thread, and the time
+//	it had to wait.  The current thread's total wait on this record
+//	is kept if it is among the MaxTopWaiters largest.
+//
+//	"waitTicks" is how long the thread was blocked.
+//	"blocked" is TRUE if it had to block at all.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Acquired(int waitTicks, bool blocked)
+{
+    int tid = currentThread->getTid();
+    int i, min;
+
+    acquisitions++;
+    if (!blocked)
+	return;
+    contended++;
+    totalWait += waitTicks;
+    if (waitTicks > maxWait)
+	maxWait = waitTicks;
+
+    for (i = 0; i < numWaiters; i++)
+	if (waiters[i].tid == tid
+		&& !strncmp(waiters[i].name, currentThread->getName(),
+			    sizeof(waiters[i].name) - 1)) {
+	    waiters[i].waitTicks += waitTicks;
+	    return;
+	}
+    //表满时替换等待最少的一个（如果我们等得更久）
+    if (numWaiters < MaxTopWaiters)
+	i = numWaiters++;
+    else {
+	for (min = 0, i = 1; i < numWaiters; i++)
+	    if (waiters[i].waitTicks < waiters[min].waitTicks)
+		min = i;
+	if (waiters[min].waitTicks >= waitTicks)
+	    return;
+	i = min;
+    }
+    strncpy(waiters[i].name, currentThread->getName(),
+	    sizeof(waiters[i].name) - 1);
+    waiters[i].name[sizeof(waiters[i].name) - 1] = '\0';
+    waiters[i].tid = tid;
+    waiters[i].waitTicks = waitTicks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Released
+// 	Count a lock release, and how long the lock was held.
+//
+//	"holdTicks" is the time since the lock was acquired.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Released(int holdTicks)
+{
+    releases++;
+    totalHold += holdTicks;
+    if (holdTicks > maxHold)
+	maxHold = holdTicks;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Print
+// 	Print one line for the record, then its top waiters, most
+//	waiting first.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Print()
+{
+    bool printed[MaxTopWaiters];
+    int i, j, best;
+
+    printf("  %-9s %-20s %7d %7d %9d %7d", kindNames[kind], name,
+	acquisitions, contended, totalWait, maxWait);
+    if (kind == LockKind || (kind == MixedKind && releases > 0))
+	printf(" %9d %7d", totalHold, maxHold);
+    printf("\n");
+
+    for (i = 0; i < numWaiters; i++)
+	printed[i] = FALSE;
+    for (j = 0; j < numWaiters; j++) {
+	best = -1;
+	for (i = 0; i < numWaiters; i++)
+	    if (!printed[i] && (best < 0
+			|| waiters[i].waitTicks > waiters[best].waitTicks))
+		best = i;
+	printed[best] = TRUE;
+	printf("      waiter %-15s %5d %9d\n", waiters[best].name,
+	    waiters[best].tid, waiters[best].waitTicks);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::SynchProfiler
+// 	Initialize the profiler, with no records.
+//----------------------------------------------------------------------
+
+SynchProfiler::SynchProfiler()
+{
+    numProfiles = 0;
+    others = NULL;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::~SynchProfiler
+// 	De-allocate the records.
+//----------------------------------------------------------------------
+
+SynchProfiler::~SynchProfiler()
+{
+    for (int i = 0; i < numProfiles; i++)
+	delete profiles[i];
+    delete others;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Register
+// 	Return the record for a new synchronization object.  Objects of
+//	the same kind and name share a record; once MaxSynchProfiles
+//	names are known, new ones share a single "(others)" record, of
+//	whatever kind they are.
+//
+//	"kind" is what sort of object it is.
+//	"name" is its debugging name.
+//----------------------------------------------------------------------
+
+SynchProfile *
+SynchProfiler::Register(SynchKind kind, char *name)
+{
+    SynchProfile *profile;
+
+    for (int i = 0; i < numProfiles; i++) {
+	profile = profiles[i];
+	if (profile->kind == kind
+		&& !strncmp(profile->name, name, sizeof(profile->name) - 1))
+	    return profile;
+    }
+    if (numProfiles < MaxSynchProfiles) {
+	profile = new SynchProfile(kind, name);
+	profiles[numProfiles++] = profile;
+	return profile;
+    }
+    if (others == NULL)
+	others = new SynchProfile(MixedKind, "(others)");
+    return others;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Print
+// 	Print the records that were used, the one with the most time
+//	spent waiting first.  Called when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+SynchProfiler::Print()
+{
+    bool printed[MaxSynchProfiles];
+    int i, j, best;
+
+    printf("Synchronization profile (kind, name, acquisitions, contended, "
+	"wait total, max; locks: hold total, max):\n");
+    for (i = 0; i < numProfiles; i++)
+	printed[i] = FALSE;
+    for (j = 0; j < numProfiles; j++) {
+	best = -1;
+	for (i = 0; i < numProfiles; i++)
+	    if (!printed[i] && (best < 0
+		    || profiles[i]->totalWait > profiles[best]->totalWait))
+		best = i;
+	printed[best] = TRUE;
+	if (profiles[best]->acquisitions > 0)
+	    profiles[best]->Print();
+    }
+    if (others != NULL && others->acquisitions > 0)
+	others->Print();
+}
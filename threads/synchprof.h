@@ -0,0 +1,86 @@
+// synchprof.h
+//	Data structures for profiling contention on semaphores, locks
+//	and condition variables.
+//
+//	With "-lp", every synchronization object gets a profile record,
+//	shared by all the objects of the same kind and name (so all the
+//	per-request semaphores of the disk driver, say, add up to one
+//	line).  A record counts how often the object was used, how often
+//	a thread had to wait for it, how long threads waited and, for
+//	locks, how long they were held.  It also remembers the few
+//	threads that waited longest.  The records are printed, worst
+//	first, when Nachos halts.
+//
+//	Without "-lp" the synchronization routines check one pointer
+//	and do nothing else.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROF_H
+#define SYNCHPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define MaxSynchProfiles	128	// distinct names we keep apart
+#define MaxTopWaiters		4	// waiters remembered per record
+
+// MixedKind is for the "(others)" record, which objects of any kind share
+enum SynchKind { SemaphoreKind, LockKind, ConditionKind, MixedKind };
+
+// A thread that waited on an object, and how long, in total
+typedef struct synchWaiter {
+    char name[16];		// thread name, truncated
+    int tid;
+    int waitTicks;
+} SynchWaiter;
+
+// The following class records the use of the synchronization objects
+// of one kind with one name.
+
+class SynchProfile {
+  public:
+    SynchProfile(SynchKind k, char *debugName);	// initialize to zero
+
+    void Acquired(int waitTicks, bool blocked);
+				// one P, Acquire or Wait is done, after
+				// waiting waitTicks
+    void Released(int holdTicks);	// a lock was held for holdTicks
+    void Print();		// print the record, and its top waiters
+
+    SynchKind kind;
+    char name[32];		// name of the objects, truncated
+    int acquisitions;		// P, Acquire or Wait calls
+    int contended;		// ... that had to wait
+    int totalWait;		// time spent waiting
+    int maxWait;
+    int releases;		// lock releases
+    int totalHold;		// time the lock was held
+    int maxHold;
+
+  private:
+    SynchWaiter waiters[MaxTopWaiters];	// the threads that waited most
+    int numWaiters;
+};
+
+// The following class keeps all the profile records.
+
+class SynchProfiler {
+  public:
+    SynchProfiler();		// no records yet
+    ~SynchProfiler();
+
+    SynchProfile *Register(SynchKind kind, char *name);
+				// the record for an object of this kind
+				// and name, created if needed
+    void Print();		// print the records, most waited on first
+
+  private:
+    SynchProfile *profiles[MaxSynchProfiles];
+    int numProfiles;
+    SynchProfile *others;	// shared by everything that didn't fit
+};
+
+#endif // SYNCHPROF_H
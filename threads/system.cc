@@ -7,6 +7,13 @@
 
 #include "copyright.h"
 #include "system.h"
+#include "fairsched.h"
+#include "stridesched.h"
+#include "edfsched.h"
+#include "replay.h"
+#ifdef USER_PROGRAM
+#include "pcprof.h"
+#endif
 
 // This defines *all* of the global data structures used by Nachos.
 // These are all initialized and de-allocated by this file.
@@ -19,9 +26,12 @@ Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
                     // for invoking context switches
                     
-int tid_flag[MAXTHREAD];      //声明threadid数组
-int threadNum;          //声明线程数量
-Thread *t_pointer[MAXTHREAD]; //声明线程指针数组
+ThreadTable *threadTable;		//所有线程，tid为索引
+int numCPUs;				// number of simulated processors
+CPU *cpus[MaxCPUs];			// the processors
+CPU *currentCPU;			// the one being simulated now
+SynchProfiler *synchProfiler;		// contention records, NULL
+					// unless profiling
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -58,16 +68,35 @@ extern void Cleanup();
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	If no other thread is ready, a yield would just switch back to
+//	the interrupted thread, so we stop the timer instead; the
+//	scheduler starts it again when some thread becomes ready.
+//
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
 TimerInterruptHandler(int dummy)
 {
+    if (scheduler->IsEmpty()) {
+	timer->Stop();			// nothing to time-slice against
+	return;
+    }
     if (interrupt->getStatus() != IdleMode)
 	interrupt->YieldOnReturn();
 }
 
+//----------------------------------------------------------------------
+// CPUTime
+// 	Return how far simulated time has got on a processor: the
+//	machine's clock for the current one, the saved clock for others.
+//----------------------------------------------------------------------
+int
+CPUTime(CPU *cpu)
+{
+    return (cpu == currentCPU) ? stats->totalTicks : cpu->clock;
+}
+
 //----------------------------------------------------------------------
 // Initialize
 // 	Initialize Nachos global data structures.  Interpret command
@@ -83,16 +112,20 @@ Initialize(int argc, char **argv)
 {
     int argCount;
     char* debugArgs = "";
+    char* traceArgs = "";		// trace points to record
+    char* policy = "priority";	// scheduling policy
+    char* replayFile = NULL;		// log of non-deterministic inputs
+    ReplayMode replay = ReplayOff;	// ... and what to do with it
     bool randomYield = FALSE;
-    //初始化tid_flag t_pointer
-    for(int i = 0; i < MAXTHREAD; i++){
-        tid_flag[i]=0;
-        t_pointer[i]=NULL;
-    }
-    threadNum = 0;
+    bool profileSynch = FALSE;		// profile synchronization?
+    //初始化线程表，从128项开始，不够时加倍
+    threadTable = new ThreadTable(128, MAXTHREAD);
+    numCPUs = 1;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char *cacheSpec = NULL;	// caches in front of memory
+    int missPenalty = 0;	// ... and what a miss costs
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -117,10 +150,45 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-cpus")) {
+	    ASSERT(argc > 1);
+	    numCPUs = atoi(*(argv + 1));	// simulate a multiprocessor
+	    ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tr")) {
+	    ASSERT(argc > 1);
+	    traceArgs = *(argv + 1);		// record trace points
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-lp")) {
+	    profileSynch = TRUE;		// profile lock contention
+	} else if (!strcmp(*argv, "-sp")) {
+	    ASSERT(argc > 1);
+	    policy = *(argv + 1);		// scheduling policy
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-rec") || !strcmp(*argv, "-rep")) {
+	    ASSERT(argc > 1);
+	    replayFile = *(argv + 1);		// record or replay inputs
+	    replay = !strcmp(*argv, "-rec") ? ReplayRecording
+					    : ReplayReplaying;
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-pc")) {
+	    ASSERT(argc > 1);
+	    pcSampleInterval = atoi(*(argv + 1));	// sample user PCs
+	    ASSERT(pcSampleInterval > 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-cache")) {
+	    ASSERT(argc > 1);
+	    cacheSpec = *(argv + 1);		// simulate caches
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-mp")) {
+	    ASSERT(argc > 1);
+	    missPenalty = atoi(*(argv + 1));	// ticks per cache miss
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -141,8 +209,34 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    if (profileSynch)				// and lock contention
+	synchProfiler = new SynchProfiler();
+    TraceInit(traceArgs);			// and trace events
+    if (replayFile != NULL)			// and non-deterministic inputs
+	ReplayInit(replayFile, replay);
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
+    for (int i = 0; i < numCPUs; i++)		// and the processors
+	cpus[i] = new CPU(i);
+    currentCPU = cpus[0];
+    //只有优先级调度支持多处理器
+    ASSERT(numCPUs == 1 || !strcmp(policy, "priority"));
+    //按-sp选择调度策略
+    if (!strcmp(policy, "priority"))
+	scheduler = new Scheduler();		// initialize the ready queue
+    else if (!strcmp(policy, "fair"))
+	scheduler = new FairScheduler();
+    else if (!strcmp(policy, "stride") || !strcmp(policy, "lottery")) {
+	if (!strcmp(policy, "stride"))
+	    scheduler = new StrideScheduler();
+	else
+	    scheduler = new LotteryScheduler();
+	stats->reportShares = TRUE;
+    } else if (!strcmp(policy, "edf"))
+	scheduler = new EDFScheduler();
+    else {
+	printf("Unknown scheduling policy \"%s\"\n", policy);
+	ASSERT(FALSE);
+    }
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
@@ -153,12 +247,25 @@ Initialize(int argc, char **argv)
     // object to save its state. 
     currentThread = new Thread("main", 1);	
     currentThread->setStatus(RUNNING);
+    currentThread->cpu = currentCPU;
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    //每个CPU有自己的Machine（寄存器、TLB、cache），共享内存
+    for (int i = 0; i < numCPUs; i++) {
+	cpus[i]->machine = (i == 0) ? machine : new Machine(debugUserProg);
+	if (cacheSpec != NULL)
+	    cpus[i]->machine->ConfigureCaches(cacheSpec, missPenalty);
+    }
+    //多处理器上用户程序在各CPU的宿主线程上并行运行；单步调试和
+    //记录、重放时仍轮流运行，才能复现；PC采样时也轮流运行，
+    //否则采样中断看不到宿主线程上正在运行的用户程序
+    if (numCPUs > 1 && !debugUserProg && replayMode == ReplayOff
+	    && pcSampleInterval == 0)
+	StartHostCPUs();
 #endif
 
 #ifdef FILESYS
@@ -182,12 +289,15 @@ void
 Cleanup()
 {
     printf("\nCleaning up...\n");
+    TraceDump(TraceFileName);
+    ReplayEnd();
 #ifdef NETWORK
     delete postOffice;
 #endif
     
 #ifdef USER_PROGRAM
-    delete machine;
+    if (!hostCPUs)			// else the host threads may be using it
+	delete machine;
 #endif
 
 #ifdef FILESYS_NEEDED
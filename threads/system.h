@@ -15,6 +15,10 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "threadtable.h"
+#include "cpu.h"
+#include "synchprof.h"
+#include "trace.h"
 
 
 // Initialization and cleanup routines
@@ -30,10 +34,16 @@ extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
 
-#define MAXTHREAD 128			//定义最大线程数
-extern int tid_flag[MAXTHREAD];		//记录threadID是否占用
-extern int threadNum;			//记录线程数量
-extern Thread *t_pointer[MAXTHREAD];	//线程指针数组，tid为索引
+#define MAXTHREAD 32768			//定义最大线程数
+extern ThreadTable *threadTable;	//所有线程，tid为索引
+
+extern int numCPUs;			// number of simulated processors
+extern CPU *cpus[MaxCPUs];		// the processors
+extern CPU *currentCPU;			// the one being simulated now
+extern int CPUTime(CPU *cpu);		// current time on a processor
+
+extern SynchProfiler *synchProfiler;	// contention records, NULL
+					// unless profiling
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -19,11 +19,74 @@
 #include "switch.h"
 #include "synch.h"
 #include "system.h"
+#ifdef USER_PROGRAM
+#include "pcprof.h"
+#endif
 
 #define STACK_FENCEPOST 0xdeadbeef	// this is put at the top of the
 					// execution stack, for detecting 
 					// stack overflows
 
+// Thread stacks are carved out of one reservation of host address
+// space, with room for as many as there can be threads, rather than
+// each mapped with its own guard pages: the host would run out of
+// mappings long before MAXTHREAD threads (see ReserveBoundedArrays).
+// Stacks of threads that have gone away are kept for new threads, on
+// a list linked through their first word; beyond the first
+// MaxCachedStacks of them, their memory goes back to the host.
+#define MaxCachedStacks 16
+static char *stackPool = NULL;		// the reservation, if it was had
+static int stackPoolSize = -1;		// stacks it has room for; -1 until
+					// the first stack is needed
+static int stackPoolUsed = 0;		// stacks handed out of it so far
+static int *freeStacks = NULL;		// stacks of threads gone away
+static int numFreeStacks = 0;
+
+//----------------------------------------------------------------------
+// NewStack, FreeStack
+// 	Get a stack, from the free list if there is one there, otherwise
+//	fresh from the reservation; NULL if the host has run out of
+//	memory.  And give one back.
+//----------------------------------------------------------------------
+
+static int *
+NewStack()
+{
+    int *stack;
+
+    if (freeStacks != NULL) {
+	stats->numStackReuses++;
+	stack = freeStacks;
+	freeStacks = *(int **) stack;
+	numFreeStacks--;
+	return stack;
+    }
+    if (stackPoolSize == -1) {
+	stackPool = ReserveBoundedArrays(StackSize * sizeof(int), MAXTHREAD);
+	stackPoolSize = (stackPool != NULL) ? MAXTHREAD : 0;
+    }
+    if (stackPoolUsed < stackPoolSize) {
+	stack = (int *) CommitBoundedArray(stackPool, StackSize * sizeof(int),
+					   stackPoolUsed);
+	if (stack != NULL)
+	    stackPoolUsed++;
+    } else				// no reservation; map it by itself
+	stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (stack != NULL)
+	stats->numStackAllocs++;
+    return stack;
+}
+
+static void
+FreeStack(int *stack)
+{
+    if (numFreeStacks >= MaxCachedStacks)
+	DiscardBoundedArray((char *) stack, StackSize * sizeof(int));
+    *(int **) stack = freeStacks;
+    freeStacks = stack;
+    numFreeStacks++;
+}
+
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
@@ -39,39 +102,45 @@ Thread::Thread(char* threadName, int p=10)
     stack = NULL;
     status = JUST_CREATED;
     //分配tid
-    this->tid=-1;
     this->uid = 0;
-    for(int i=0;i<128;i++){
-        if(tid_flag[i]==0){
-            this->tid = i;
-            tid_flag[i]=1;
-            t_pointer[i]=this;
-            threadNum++;
-            break;
-        }
-    }
-    //未分配到id
+    this->tid = threadTable->Add(this);
+    //未分配到id，Fork时失败
     if(this->tid==-1){
         printf("线程数量达到上限，创建失败。\n");
     }
-    //*************
-    ASSERT(this->tid != -1);
     //设置优先级0-10,0最高
-    if(p<0 || p>10){
+    if(p<HighestPriority || p>LowestPriority){
         //不在范围内设置为最低
-        this->setPri(10);
+        this->setPri(LowestPriority);
     }
     else{
         this->setPri(p);
     }
+    basePri = pri;
+    heldLocks = NULL;
+    waitingOn = NULL;
 #ifdef USER_PROGRAM
     space = NULL;
+    hostTrap = NoException;
 #endif
 
-    for(int i=0;i<MaxChildThreadNum;i++){
-        childThread[i] = NULL;
+    for(int i=0;i<ChildHashSize;i++){
+        children[i] = NULL;
     }
+    exitStatus = NULL;
     fatherThread = this;
+    cpuTicks = 0;
+    lastDispatch = 0;
+    idleAtDispatch = 0;
+    readyTime = 0;
+    cpu = NULL;
+    affinity = -1;
+    vruntime = vruntimeLeft = 0;
+    pass = passLeft = 0;
+    tickets = DefaultTickets;
+    donatedTickets = 0;
+    period = budget = deadline = used = 0;
+    deadlineMisses = 0;
 }
 
 //----------------------------------------------------------------------
@@ -91,22 +160,232 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
-    //删除tid
-    tid_flag[this->tid] = 0;
-    t_pointer[this->tid] = NULL;
-    threadNum--;
+    //Fork失败的线程没有tid，也没有运行过
+    if(this->tid != -1){
+        stats->RecordThread(name, tid, tickets, cpuTicks);
+        //删除tid
+        threadTable->Remove(this->tid);
+    }
 
     if (stack != NULL)
-        DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+        FreeStack(stack);
     //threadnum--;
 #ifdef USER_PROGRAM
     if(space != NULL){
+        stats->RecordProcess(name, tid, &space->usage);
+        if (space->profile != NULL)
+            space->profile->Print(name);
         delete space;
     }
 #endif
     
 }
 
+//----------------------------------------------------------------------
+// Thread::CpuTicks
+// 	Return the CPU time this thread has used, including the time
+//	since it was last dispatched, if it is running now.
+//----------------------------------------------------------------------
+
+int
+Thread::CpuTicks()
+{
+    if (this == currentThread)
+	return cpuTicks + stats->totalTicks - lastDispatch
+		- (stats->idleTicks - idleAtDispatch);
+    return cpuTicks;
+}
+
+//----------------------------------------------------------------------
+// ChildStatus::ChildStatus, ChildStatus::~ChildStatus
+// 	Set up the exit status of a child that is still running, and
+//	de-allocate it once the parent is done with it.
+//
+//	"childPid" is the process id of the child.
+//----------------------------------------------------------------------
+
+ChildStatus::ChildStatus(int childPid)
+{
+    pid = childPid;
+    exitCode = 0;
+    exited = FALSE;
+    orphaned = FALSE;
+    done = new Semaphore("child done", 0);
+    next = NULL;
+}
+
+ChildStatus::~ChildStatus()
+{
+    delete done;
+}
+
+static int nextPid = 1;		// process ids are never reused, so a
+				// zombie can't be mistaken for a newer child
+
+//----------------------------------------------------------------------
+// Thread::AddChild
+// 	Make "child" a child of this thread, so that we can Join it.
+//	Return its process id.
+//
+//	"child" is the new thread; it must not have been forked yet.
+//----------------------------------------------------------------------
+
+int
+Thread::AddChild(Thread *child)
+{
+    ChildStatus *cs;
+
+    ASSERT(child->exitStatus == NULL);
+    cs = new ChildStatus(nextPid++);
+    cs->next = children[cs->pid % ChildHashSize];
+    children[cs->pid % ChildHashSize] = cs;
+    child->exitStatus = cs;
+    child->fatherThread = this;
+    return cs->pid;
+}
+
+//----------------------------------------------------------------------
+// Thread::Join
+// 	Wait until one of our children finishes, and return its exit
+//	code.  A child that has already finished returns at once.  A
+//	child can only be joined once; return -1 if "pid" isn't a child
+//	we haven't joined yet.
+//
+//	"pid" is the process id returned by AddChild.
+//----------------------------------------------------------------------
+
+int
+Thread::Join(int pid)
+{
+    ChildStatus **p, *child;
+    int exitCode;
+
+    ASSERT(this == currentThread);
+    if (pid <= 0)
+	return -1;
+    for (p = &children[pid % ChildHashSize]; *p != NULL; p = &(*p)->next)
+	if ((*p)->pid == pid)
+	    break;
+    child = *p;
+    if (child == NULL)
+	return -1;
+    *p = child->next;			// nobody else can join it now
+    child->done->P();			// sleep until it has finished
+    exitCode = child->exitCode;
+    delete child;
+    return exitCode;
+}
+
+//----------------------------------------------------------------------
+// Thread::AddUsage
+// 	Count some use of a resource by this thread, and by the user
+//	program it runs, if any.
+//
+//	"r" is the resource.
+//	"n" is how much of it was used.
+//----------------------------------------------------------------------
+
+void
+Thread::AddUsage(Resource r, int n)
+{
+    usage.count[r] += n;
+#ifdef USER_PROGRAM
+    if (space != NULL)
+	space->usage.count[r] += n;
+#endif
+}
+
+//----------------------------------------------------------------------
+// Thread::SetBasePriority
+// 	Change the priority of this thread.  While it holds a lock that
+//	a higher priority thread is waiting for, it keeps running at
+//	that thread's priority.
+//
+//	"p" is the new priority, HighestPriority .. LowestPriority.
+//----------------------------------------------------------------------
+
+void
+Thread::SetBasePriority(int p)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT((p >= HighestPriority) && (p <= LowestPriority));
+    basePri = p;
+    UpdatePriority();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Thread::UpdatePriority
+// 	Priority inheritance: run at the best of our own priority and
+//	the priorities inherited through the locks we hold (see
+//	Lock::InheritedPriority).  If that changes, and we are ourselves
+//	waiting for a lock, the holder of that lock may have to change
+//	too, and so on down the chain.
+//
+//	Called with interrupts disabled, whenever a thread starts or
+//	stops waiting for a lock, or acquires or releases one.
+//----------------------------------------------------------------------
+
+#define MaxInheritDepth 16	// longest chain of lock holders we follow
+
+void
+Thread::UpdatePriority()
+{
+    Thread *t = this;
+    Lock *lock;
+    int p, q, depth;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    for (depth = 0; t != NULL && depth < MaxInheritDepth; depth++) {
+	p = t->basePri;
+	for (lock = t->heldLocks; lock != NULL; lock = lock->nextHeld) {
+	    q = lock->InheritedPriority();
+	    if (q < p)
+		p = q;
+	}
+	if (p == t->getPri())
+	    break;
+	DEBUG('t', "Thread \"%s\" now runs at priority %d (own %d)\n",
+	      t->getName(), p, t->basePri);
+	scheduler->ChangePriority(t, p);
+	t = (t->waitingOn != NULL) ? t->waitingOn->Holder() : NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::SetPeriodic
+// 	Ask the scheduler to run this thread as a periodic real-time
+//	thread: "ticks" ticks of CPU every "interval" ticks, starting now.
+//	Return FALSE if the scheduler can't guarantee that.
+//----------------------------------------------------------------------
+
+bool
+Thread::SetPeriodic(int interval, int ticks)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool admitted = scheduler->AdmitPeriodic(this, interval, ticks);
+
+    (void) interrupt->SetLevel(oldLevel);
+    return admitted;
+}
+
+//----------------------------------------------------------------------
+// Thread::WaitForNextPeriod
+// 	Called by a periodic thread when it has finished the work for
+//	this period; returns at the start of the next one.
+//----------------------------------------------------------------------
+
+void
+Thread::WaitForNextPeriod()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(this == currentThread);
+    scheduler->WaitForNextPeriod(this);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Thread::Fork
 // 	Invoke (*func)(arg), allowing caller and callee to execute 
@@ -123,22 +402,32 @@ Thread::~Thread()
 //		cause it to run the procedure
 //		3. Put the thread on the ready queue
 // 	
+//	Returns FALSE, and leaves the thread to be deleted, if it didn't
+//	get a thread id (there were MAXTHREAD threads already), or the
+//	host has no memory left for its stack.
+//
 //	"func" is the procedure to run concurrently.
 //	"arg" is a single argument to be passed to the procedure.
 //----------------------------------------------------------------------
 
-void 
+bool
 Thread::Fork(VoidFunctionPtr func, void *arg)
 {
     DEBUG('t', "Forking thread \"%s\" with func = 0x%x, arg = %d\n",
 	  name, (int) func, (int*) arg);
     
-    StackAllocate(func, arg);
-    printf("[thread]thread (%s) Fork.\n",name);
+    if (tid == -1)
+	return FALSE;			// already reported
+    if (!StackAllocate(func, arg)) {
+	printf("线程栈分配失败，创建失败。\n");
+	return FALSE;
+    }
+    TRACE('t', TraceFork, tid, pri, 0);
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     scheduler->ReadyToRun(this);	// ReadyToRun assumes that interrupts 
 					// are disabled!
     (void) interrupt->SetLevel(oldLevel);
+    return TRUE;
 }    
 
 //----------------------------------------------------------------------
@@ -180,18 +469,48 @@ Thread::CheckOverflow()
 //
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
+//
+//	"exitCode" is handed to the parent, if it joins us.
 //----------------------------------------------------------------------
 
 //
 void
-Thread::Finish ()
+Thread::Finish (int exitCode)
 {
+    ChildStatus *child, *next;
+
     (void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
     
-    DEBUG('t', "Finishing thread \"%s\"\n", getName());
+    DEBUG('t', "Finishing thread \"%s\", exit code %d\n", getName(),
+	  exitCode);
+    TRACE('t', TraceFinish, exitCode, 0, 0);
     
+    //把退出码交给父线程并唤醒它；父线程已结束则自己释放
+    if (exitStatus != NULL) {
+	if (exitStatus->orphaned)
+	    delete exitStatus;
+	else {
+	    exitStatus->exitCode = exitCode;
+	    exitStatus->exited = TRUE;
+	    exitStatus->done->V();
+	}
+	exitStatus = NULL;
+    }
+    //没有被join的子线程：已结束的释放，未结束的由它们自己释放
+    for (int i = 0; i < ChildHashSize; i++) {
+	for (child = children[i]; child != NULL; child = next) {
+	    next = child->next;
+	    if (child->exited)
+		delete child;
+	    else
+		child->orphaned = TRUE;
+	}
+	children[i] = NULL;
+    }
+
     threadToBeDestroyed = currentThread;
+    scheduler->EndPeriodic(this);		// give back its CPU reservation
     //printf("sleep\n");
     Sleep();					// invokes SWITCH
     // not reached
@@ -232,6 +551,9 @@ Thread::Yield ()
     //printf("[thread227]next thread %s\n",nextThread->getName());
     if (nextThread != NULL) {
         scheduler->Run(nextThread);
+    } else if (status == BLOCKED) {
+        //调度器没有让我们回到就绪队列（如超出预算被扣留），等待放行
+        Sleep();
     }
     (void) interrupt->SetLevel(oldLevel);
 }
@@ -292,14 +614,18 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 //		calls (*func)(arg)
 //		calls Thread::Finish
 //
+//	Returns FALSE if there is no memory for the stack.
+//
 //	"func" is the procedure to be forked
 //	"arg" is the parameter to be passed to the procedure
 //----------------------------------------------------------------------
 
-void
+bool
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = NewStack();
+    if (stack == NULL)
+	return FALSE;
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -328,6 +654,7 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
     machineState[InitialPCState] = (int*)func;
     machineState[InitialArgState] = arg;
     machineState[WhenDonePCState] = (int*)ThreadFinish;
+    return TRUE;
 }
 
 #ifdef USER_PROGRAM
@@ -340,13 +667,21 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine saves the former.
+//
+//	"from" is the Machine holding them, if not the current CPU's.
 //----------------------------------------------------------------------
 
 void
 Thread::SaveUserState()
+{
+    SaveUserState(machine);
+}
+
+void
+Thread::SaveUserState(Machine *from)
 {
     for (int i = 0; i < NumTotalRegs; i++)
-	userRegisters[i] = machine->ReadRegister(i);
+	userRegisters[i] = from->ReadRegister(i);
 }
 
 //----------------------------------------------------------------------
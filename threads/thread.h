@@ -39,6 +39,29 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "cpu.h"
+#include "stats.h"
+
+class Lock;
+class Semaphore;
+
+// The exit status of a child thread.  It is shared by the child and
+// its parent, and outlives the child until the parent joins it (so an
+// exited child is a "zombie" until then).  If the parent finishes
+// first, the child frees it when it exits.
+
+class ChildStatus {
+  public:
+    ChildStatus(int childPid);	// a child that is still running
+    ~ChildStatus();
+
+    int pid;			// process id, never reused
+    int exitCode;		// passed to Finish, valid once exited
+    bool exited;		// has the child finished?
+    bool orphaned;		// has the parent finished?
+    Semaphore *done;		// signalled when the child finishes
+    ChildStatus *next;		// next child in the same hash bucket
+};
 
 
 #ifdef USER_PROGRAM
@@ -50,7 +73,15 @@
 // The SPARC and MIPS only need 10 registers, but the Snake needs 18.
 // For simplicity, this is just the max over all architectures.
 #define MachineStateSize 18 
-#define MaxChildThreadNum 10
+#define ChildHashSize 16		// buckets in a thread's child table
+
+// Thread priorities, 0 is the highest
+#define HighestPriority	0
+#define LowestPriority	10
+#define NumPriorities	(LowestPriority + 1)
+
+// Tickets a thread starts with, for proportional-share scheduling
+#define DefaultTickets	100
 
 
 // Size of the thread's private execution stack.
@@ -94,12 +125,13 @@ class Thread {
     
     // basic thread operations
 
-    void Fork(VoidFunctionPtr func, void *arg); 	// Make thread run (*func)(arg)
+    bool Fork(VoidFunctionPtr func, void *arg); 	// Make thread run (*func)(arg);
+					// FALSE if it couldn't be created
     void Yield();  				// Relinquish the CPU if any 
 						// other thread is runnable
     void Sleep();  				// Put the thread to sleep and 
 						// relinquish the processor
-    void Finish();  				// The thread is done executing
+    void Finish(int exitCode = 0);		// The thread is done executing
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
@@ -108,12 +140,70 @@ class Thread {
     int getTid(){ return this->tid; }  
     int getUid(){ return this->uid; }
     int getPri(){ return this->pri; }
-    void setPri(int p){ this->pri = p; }
+    void setPri(int p){ this->pri = p; }	// priority scheduled at
+    void SetBasePriority(int p);	// priority when no lock is boosting
+					// it
+    void UpdatePriority();		// recompute the inherited priority,
+					// and pass it on to lock holders
+    ThreadStatus getStatus() { return status; }
+    void setTickets(int n){ ASSERT(n > 0); this->tickets = n; }
+    void setAffinity(int c){ ASSERT(c >= -1 && c < MaxCPUs); affinity = c; }
+					// prefer CPU c, -1 for any
+    int Tickets(){ return tickets + donatedTickets; }
+					// own tickets, plus those lent by
+					// threads waiting on us
+    int CpuTicks();			// CPU time used so far
+    void AddUsage(Resource r, int n);	// count resources used, also
+					// against our address space
+
+    bool SetPeriodic(int interval, int ticks);	// become a periodic
+					// real-time thread, if admitted
+    void WaitForNextPeriod();		// this period's job is done
     void Print() { printf("%s, ", name); }
 
-    Thread *childThread[MaxChildThreadNum];
+    int AddChild(Thread *child);	// make child ours, return its pid
+    int Join(int pid);			// wait for a child to finish,
+					// return its exit code
+
+    ChildStatus *children[ChildHashSize];	// children not yet joined,
+					// hashed by pid
+    ChildStatus *exitStatus;		// shared with our parent, NULL if
+					// nobody will join us
     Thread *fatherThread;
 
+    //CPU时间统计，由调度器维护
+    int cpuTicks;			// total ticks this thread has run
+    int lastDispatch;			// when it was last given the CPU
+    int idleAtDispatch;			// stats->idleTicks at that time
+    int readyTime;			// when it last became ready
+    CPU *cpu;				// processor it runs on, NULL until
+					// it is first made ready
+    int affinity;			// processor it should run on, or -1
+    int vruntime;			// weighted CPU time, for FairScheduler
+    int vruntimeLeft;			// ... remainder, in ticks times
+					// NiceZeroWeight
+    int pass;				// for StrideScheduler
+    int passLeft;			// ... remainder, in ticks times
+					// StrideScale
+    int tickets;			// proportional share of the CPU
+    int donatedTickets;			// lent by threads blocked on
+					// locks we hold
+
+    ResourceUsage usage;		// what this thread has used
+
+    //优先级继承
+    int basePri;			// own priority, before inheritance
+    Lock *heldLocks;			// locks we hold, linked by
+					// Lock::nextHeld
+    Lock *waitingOn;			// lock we are blocked on, or NULL
+
+    //周期性实时线程，用于EDFScheduler
+    int period;				// 0 if not periodic
+    int budget;				// CPU ticks allowed per period
+    int deadline;			// end of the current period
+    int used;				// ticks used in the current period
+    int deadlineMisses;			// jobs finished late
+
   private:
     // some of the private data for this class is listed above
     
@@ -128,7 +218,7 @@ class Thread {
     int uid;
     //优先级
     int pri;
-    void StackAllocate(VoidFunctionPtr func, void *arg);
+    bool StackAllocate(VoidFunctionPtr func, void *arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
 
@@ -141,7 +231,11 @@ class Thread {
 
   public:
     void SaveUserState();		// save user-level register state
+    void SaveUserState(Machine *from);	// ... from the Machine of a CPU
+					// other than the current one
     void RestoreUserState();		// restore user-level register state
+    ExceptionType hostTrap;		// raised on a CPU's host thread, and
+					// not yet taken
     //挂起线程
     void Suspend();
     AddrSpace *space;			// User code this thread is running.
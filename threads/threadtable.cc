@@ -0,0 +1,131 @@
+// threadtable.cc 
+//	Routines to manage the table of all threads.  See threadtable.h
+//	for a description.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize a table with no threads in it.  All ids are free, and
+//	are put on the free list lowest first.
+//
+//	"initialSize" is the number of entries to start with.
+//	"limit" is the most threads that may exist at once.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable(int initialSize, int limit)
+{
+    ASSERT(initialSize > 0 && initialSize <= limit);
+    size = initialSize;
+    maxSize = limit;
+    table = new Thread *[size];
+    nextFree = new int[size];
+    for (int i = 0; i < size; i++) {
+	table[i] = NULL;
+	nextFree[i] = (i + 1 < size) ? i + 1 : -1;
+    }
+    freeHead = 0;
+    numThreads = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table.  The threads themselves are not deleted.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete [] table;
+    delete [] nextFree;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the size of the table (no further than maxSize), and put
+//	the new ids on the free list.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Grow()
+{
+    int newSize = (size * 2 < maxSize) ? size * 2 : maxSize;
+    Thread **newTable = new Thread *[newSize];
+    int *newNext = new int[newSize];
+    int i;
+
+    for (i = 0; i < size; i++) {
+	newTable[i] = table[i];
+	newNext[i] = nextFree[i];
+    }
+    for (i = size; i < newSize; i++) {
+	newTable[i] = NULL;
+	newNext[i] = (i + 1 < newSize) ? i + 1 : freeHead;
+    }
+    freeHead = size;
+    delete [] table;
+    delete [] nextFree;
+    table = newTable;
+    nextFree = newNext;
+    size = newSize;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Take an id off the free list for a new thread, growing the table
+//	if there are none left.  Return -1 if the table is at maxSize
+//	and full.
+//
+//	"thread" is the thread to be given an id.
+//----------------------------------------------------------------------
+
+int
+ThreadTable::Add(Thread *thread)
+{
+    int tid;
+
+    if (freeHead == -1) {
+	if (size == maxSize)
+	    return -1;
+	Grow();
+    }
+    tid = freeHead;
+    freeHead = nextFree[tid];
+    table[tid] = thread;
+    numThreads++;
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Put the id of a thread that is going away back on the free list.
+//
+//	"tid" is the id to free.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Remove(int tid)
+{
+    ASSERT(tid >= 0 && tid < size && table[tid] != NULL);
+    table[tid] = NULL;
+    nextFree[tid] = freeHead;
+    freeHead = tid;
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with a given id, NULL if the id isn't in use.
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int tid)
+{
+    if (tid < 0 || tid >= size)
+	return NULL;
+    return table[tid];
+}
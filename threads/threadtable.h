@@ -0,0 +1,45 @@
+// threadtable.h 
+//	Data structures for the table of all threads, indexed by thread id.
+//
+//	Thread ids are handed out from a free list, so allocating and
+//	freeing one takes constant time.  The table starts small and
+//	doubles when it runs out of ids, up to MAXTHREAD entries.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+class ThreadTable {
+  public:
+    ThreadTable(int initialSize, int limit);
+				// initialize an empty table
+    ~ThreadTable();		// de-allocate the table
+
+    int Add(Thread *thread);	// give thread an id; -1 if the table
+				// is full
+    void Remove(int tid);	// free the id of a thread going away
+    Thread *Lookup(int tid);	// the thread with this id, or NULL
+
+    int NumThreads() { return numThreads; }
+    int Size() { return size; }	// ids are all below this
+
+  private:
+    void Grow();		// double the size of the table
+
+    Thread **table;		// thread of each id, NULL if free
+    int *nextFree;		// free list of ids, -1 terminated
+    int freeHead;		// first free id, -1 if none
+    int size;			// number of entries in the table
+    int maxSize;		// don't grow beyond this
+    int numThreads;		// number of ids in use
+};
+
+#endif // THREADTABLE_H
@@ -14,6 +14,7 @@
 #include "elevatortest.h"
 #include "list.h"
 #include "synch.h"
+#include "fairsched.h"
 
 extern void StartProcess(char *filename);
 
@@ -97,24 +98,40 @@ void ThreadTest1()
 }
 
 //最大线程测试
+//建满MAXTHREAD个线程（加上main线程），再多建一个应该失败并可以删除
+//nachos -q 2
 void maxThreadTest()
 {
-    DEBUG('t', "Entering ThreadTest1");
+    DEBUG('t', "Entering maxThreadTest");
 
-    int createNum = 127;
+    int createNum = MAXTHREAD - 1;  //加上main线程正好达到上限
+    int created = 0;
     for(int i=0;i<createNum;i++){
         Thread *t = new Thread("thread");
-        t->Fork(PrintThread, NULL);
+        if(!t->Fork(PrintThread, NULL)){
+            delete t;
+            break;
+        }
+        created++;
+    }
+    printf("%d threads forked, %d live\n", created, threadTable->NumThreads());
+
+    Thread *extra = new Thread("one too many");
+    if(extra->Fork(PrintThread, NULL)){
+        printf("thread %d forked past the limit\n", extra->getTid());
+    }else{
+        delete extra;
+        printf("thread past the limit refused\n");
     }
-    
 }
 
 //TS函数
 void ThreadShow(){
     printf("tid          uid          name\n");
-    for(int i=0; i<MAXTHREAD; i++){
-        if(t_pointer[i]!=NULL){
-            printf("%3d%11d%18s\n",t_pointer[i]->getTid(),t_pointer[i]->getUid(),t_pointer[i]->getName());
+    for(int i=0; i<threadTable->Size(); i++){
+        Thread* t = threadTable->Lookup(i);
+        if(t!=NULL){
+            printf("%3d%11d%18s\n",t->getTid(),t->getUid(),t->getName());
         }
     }
 }
@@ -301,6 +318,257 @@ void rwlockTest2(){
     //writerWithLock();
 }
 
+//公平性测试：不同优先级的计算线程同时运行一段时间，
+//比较各自得到的CPU时间与按权重应得的份额
+//票数与权重相同，所以stride/lottery下应得份额一样
+//需要时钟：nachos -rs <seed> [-sp fair|stride|lottery] -q 9
+#define FairThreadNum 4
+#define FairRunTicks 50000
+int fairPri[FairThreadNum] = {0, 3, 6, 10};
+int fairCpu[FairThreadNum];
+int fairEnd;
+int fairDone;
+
+//计算线程：一直占用CPU直到测试结束
+void fairWorker(int which){
+    while(stats->totalTicks < fairEnd){
+        //开关一次中断，模拟一个时钟的计算
+        interrupt->SetLevel(IntOff);
+        interrupt->SetLevel(IntOn);
+    }
+    fairCpu[which] = currentThread->CpuTicks();
+
+    if(++fairDone < FairThreadNum){
+        return;
+    }
+    //最后一个结束的线程打印结果
+    int total = 0, weights = 0;
+    for(int i = 0; i < FairThreadNum; i++){
+        total += fairCpu[i];
+        weights += FairScheduler::Weight(fairPri[i]);
+    }
+    printf("pri   cpu ticks   share   fair share\n");
+    for(int i = 0; i < FairThreadNum; i++){
+        printf("%3d%12d%7d%%%12d%%\n", fairPri[i], fairCpu[i],
+            fairCpu[i] * 100 / total,
+            FairScheduler::Weight(fairPri[i]) * 100 / weights);
+    }
+}
+
+void fairnessTest(){
+    if(timer == NULL){
+        printf("fairness test needs the timer, run with -rs <seed>\n");
+        return;
+    }
+    fairEnd = stats->totalTicks + FairRunTicks;
+    fairDone = 0;
+    for(int i = 0; i < FairThreadNum; i++){
+        Thread* t = new Thread("fair worker", fairPri[i]);
+        t->setTickets(FairScheduler::Weight(fairPri[i]));
+        t->Fork(fairWorker, (void*)i);
+    }
+}
+
+//EDF测试：周期性的控制线程，每个周期做一定量的计算
+//nachos -sp edf -q 10
+#define ControlJobs 5
+typedef struct controlLoop{
+    char *name;
+    int period;     //周期
+    int budget;     //每周期申请的CPU时间
+    int work;       //每周期实际的计算量
+}ControlLoop;
+ControlLoop controlLoops[] = {
+    {"loop A", 1000, 300, 250},
+    {"loop B", 2000, 600, 500},
+    {"loop C", 4000, 800, 1200},    //超出预算，会被扣留并错过截止时间
+    {"loop D", 1000, 500, 100},     //总利用率超过1，不被接纳
+};
+#define ControlLoopNum ((int) (sizeof(controlLoops) / sizeof(ControlLoop)))
+
+void controlThread(int which){
+    ControlLoop *loop = &controlLoops[which];
+    if(!currentThread->SetPeriodic(loop->period, loop->budget)){
+        printf("%s refused: period %d, budget %d\n",
+            loop->name, loop->period, loop->budget);
+        return;
+    }
+    for(int job = 0; job < ControlJobs; job++){
+        int end = currentThread->CpuTicks() + loop->work;
+        while(currentThread->CpuTicks() < end){
+            interrupt->SetLevel(IntOff);
+            interrupt->SetLevel(IntOn);
+        }
+        printf("%s job %d done at %d, deadline %d\n", loop->name, job,
+            stats->totalTicks, currentThread->deadline);
+        currentThread->WaitForNextPeriod();
+    }
+    printf("%s: %d deadline misses\n", loop->name,
+        currentThread->deadlineMisses);
+}
+
+void edfTest(){
+    for(int i = 0; i < ControlLoopNum; i++){
+        Thread* t = new Thread(controlLoops[i].name);
+        t->Fork(controlThread, (void*)i);
+    }
+}
+
+//线程创建/销毁性能测试：大量只运行一下就结束的线程
+//nachos -q 11
+#define ForkBenchNum 5000
+
+void shortLived(int which){
+}
+
+void forkBench(){
+    double start = HostSeconds();
+    int allocs = stats->numStackAllocs;
+    for(int i = 0; i < ForkBenchNum; i++){
+        //优先级比main高，Yield后立即运行并结束，下次切换时被销毁
+        Thread* t = new Thread("short lived", HighestPriority);
+        t->Fork(shortLived, (void*)i);
+        currentThread->Yield();
+    }
+    double elapsed = HostSeconds() - start;
+    printf("%d forks in %.3f s, %.2f us per fork, %d stacks allocated\n",
+        ForkBenchNum, elapsed, elapsed * 1000000 / ForkBenchNum,
+        stats->numStackAllocs - allocs);
+}
+
+//多处理器测试：计算量相同的线程分到各个CPU上并行运行，
+//比较全部完成所用的模拟时间
+//nachos -cpus <n> -q 12
+#define SmpThreadNum 8
+#define SmpWork 20000
+int smpStart;
+int smpEnd;
+int smpDone;
+
+void smpWorker(int which){
+    int end = currentThread->CpuTicks() + SmpWork;
+    while(currentThread->CpuTicks() < end){
+        interrupt->SetLevel(IntOff);
+        interrupt->SetLevel(IntOn);
+    }
+    if(stats->totalTicks > smpEnd){
+        smpEnd = stats->totalTicks;
+    }
+    printf("worker %d done on CPU %d at %d\n", which, currentCPU->id,
+        stats->totalTicks);
+    if(++smpDone == SmpThreadNum){
+        printf("%d CPUs: %d threads x %d ticks took %d ticks\n", numCPUs,
+            SmpThreadNum, SmpWork, smpEnd - smpStart);
+    }
+}
+
+void smpTest(){
+    smpStart = stats->totalTicks;
+    smpEnd = smpStart;
+    smpDone = 0;
+    for(int i = 0; i < SmpThreadNum; i++){
+        Thread* t = new Thread("smp worker");
+        t->Fork(smpWorker, (void*)i);
+    }
+}
+
+//优先级反转测试：低优先级线程持有锁时，高优先级线程等待该锁，
+//中优先级线程一直可以运行。有优先级继承时，高优先级线程的等待
+//时间不超过低优先级线程临界区的长度，与中优先级线程的计算量无关。
+//依次测试优先级继承和优先级天花板
+//nachos -q 13
+#define InversionSection 2000   //低优先级线程临界区的计算量
+#define InversionWork 20000     //中优先级线程的计算量
+Lock *inversionLock;
+Semaphore *inversionDone;
+
+//计算一段时间，每一步都让出CPU，模拟随时可能被抢占
+void busyWork(int ticks){
+    int end = stats->totalTicks + ticks;
+    while(stats->totalTicks < end){
+        interrupt->SetLevel(IntOff);
+        interrupt->SetLevel(IntOn);
+        currentThread->Yield();
+    }
+}
+
+void inversionHigh(int which){
+    int start = stats->totalTicks;
+    inversionLock->Acquire();
+    int blocked = stats->totalTicks - start;
+    inversionLock->Release();
+    printf("%s: high priority thread blocked %d ticks "
+        "(critical section %d, medium work %d)\n", inversionLock->getName(),
+        blocked, InversionSection, InversionWork);
+    inversionDone->V();
+}
+
+void inversionMedium(int which){
+    busyWork(InversionWork);
+}
+
+void inversionLow(int which){
+    inversionLock->Acquire();
+    //持有锁时中、高优先级线程就绪
+    Thread* high = new Thread("inversion high", 2);
+    Thread* medium = new Thread("inversion medium", 5);
+    high->Fork(inversionHigh, (void*)0);
+    medium->Fork(inversionMedium, (void*)0);
+    busyWork(InversionSection);
+    inversionLock->Release();
+}
+
+void inversionRounds(int which){
+    inversionDone = new Semaphore("inversion done", 0);
+
+    inversionLock = new Lock("inheritance");
+    Thread* low = new Thread("inversion low", 8);
+    low->Fork(inversionLow, (void*)0);
+    inversionDone->P();
+    delete inversionLock;
+
+    inversionLock = new Lock("ceiling", 2);
+    low = new Thread("inversion low", 8);
+    low->Fork(inversionLow, (void*)0);
+    inversionDone->P();
+    delete inversionLock;
+}
+
+void inversionTest(){
+    //由最低优先级的线程依次进行两轮测试
+    Thread* t = new Thread("inversion rounds", LowestPriority);
+    t->Fork(inversionRounds, (void*)0);
+}
+
+//票数多的线程反复Yield：每次只运行几个tick，pass也必须前进，
+//否则它一直是最小pass，默认票数的线程永远得不到CPU
+//两者都让出CPU YieldRounds次，票数多的结束时，另一个应该已经
+//运行了约 YieldRounds * DefaultTickets / YieldTickets 次
+//（-sp fair 下按两者优先级的权重，即 YieldRounds * 335 / 3121 次）
+//nachos -sp stride|fair -q 14
+#define YieldTickets 3121
+#define YieldRounds 1000
+int yieldCount[2];
+
+void yieldWorker(int which){
+    for(int i = 0; i < YieldRounds; i++){
+        yieldCount[which]++;
+        currentThread->Yield();
+    }
+    printf("yielder %d (%d tickets) done: rounds %d and %d, "
+        "cpu ticks %d\n", which, currentThread->Tickets(),
+        yieldCount[0], yieldCount[1], currentThread->CpuTicks());
+}
+
+void yieldTest(){
+    yieldCount[0] = yieldCount[1] = 0;
+    Thread* heavy = new Thread("heavy yielder", HighestPriority);
+    heavy->setTickets(YieldTickets);
+    heavy->Fork(yieldWorker, (void*)0);
+    Thread* light = new Thread("light yielder");
+    light->Fork(yieldWorker, (void*)1);
+}
+
 //----------------------------------------------------------------------
 // ThreadTest
 // 	Invoke a test routine.
@@ -334,6 +602,24 @@ ThreadTest()
     case 8:
         rwlockTest2();
         break;
+    case 9:
+        fairnessTest();
+        break;
+    case 10:
+        edfTest();
+        break;
+    case 11:
+        forkBench();
+        break;
+    case 12:
+        smpTest();
+        break;
+    case 13:
+        inversionTest();
+        break;
+    case 14:
+        yieldTest();
+        break;
     default:
 	    printf("No test specified.\n");
 	    break;
@@ -0,0 +1,123 @@
+// trace.cc
+//	Routines to record kernel events into a ring buffer, and write
+//	them out when Nachos halts.  See trace.h for how it is used.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "trace.h"
+#include "system.h"
+
+unsigned int traceMask = 0;		// no flags traced
+
+static TraceRecord *traceBuffer = NULL;	// the ring buffer
+static int traceNext = 0;		// where the next record goes
+static int traceTotal = 0;		// records ever made
+
+// Indexed by TraceEventType
+static TraceEventInfo traceEvents[NumTraceEvents] = {
+    { "switch",		"thread %d (from %d)",
+				TracePhaseBegin, TraceTrackCPU },
+    { "stop",		"thread %d stops",
+				TracePhaseEnd, TraceTrackCPU },
+    { "fork",		"fork thread %d, priority %d",
+				TracePhaseInstant, TraceTrackThread },
+    { "finish",		"finish, exit code %d",
+				TracePhaseInstant, TraceTrackThread },
+    { "page fault",	"page fault, vpn %d into frame %d",
+				TracePhaseInstant, TraceTrackThread },
+    { "syscall",	"syscall %d (%d, %d)",
+				TracePhaseBegin, TraceTrackThread },
+    { "addrspace",	"address space, %d pages at swap page %d",
+				TracePhaseInstant, TraceTrackThread },
+    { "syscall done",	"syscall returns %d",
+				TracePhaseEnd, TraceTrackThread },
+    { "interrupt",	"interrupt type %d, %d ticks late",
+				TracePhaseInstant, TraceTrackCPU },
+    { "disk",		"disk sector %d, write %d, %d ticks",
+				TracePhaseBegin, TraceTrackDisk },
+    { "disk done",	"disk done",
+				TracePhaseEnd, TraceTrackDisk },
+};
+
+//----------------------------------------------------------------------
+// TraceInit
+// 	Start recording the trace points with a flag in flagList.
+//
+// 	"flagList" is a string of DEBUG flag characters, or "+" for all.
+//----------------------------------------------------------------------
+
+void
+TraceInit(char *flagList)
+{
+    for (; *flagList != '\0'; flagList++) {
+	if (*flagList == '+' || (*flagList >= 'a' && *flagList <= 'z'))
+	    traceMask |= TraceBit(*flagList);
+    }
+    if (traceMask != 0 && traceBuffer == NULL)
+	traceBuffer = new TraceRecord[TraceBufferSize];
+}
+
+//----------------------------------------------------------------------
+// TraceEvent
+// 	Record one event, overwriting the oldest record if the buffer
+//	is full.  Called through the TRACE macro, which has already
+//	checked that the event's flag is enabled.
+//
+//	"event" is the TraceEventType.
+//	"a", "b", "c" are its arguments.
+//----------------------------------------------------------------------
+
+void
+TraceEvent(int event, int a, int b, int c)
+{
+    TraceRecord *rec = &traceBuffer[traceNext];
+
+    rec->time = stats->totalTicks;
+    rec->event = event;
+    rec->cpu = (currentCPU != NULL) ? currentCPU->id : 0;
+    rec->tid = (currentThread != NULL) ? currentThread->getTid() : -1;
+    rec->arg[0] = a;
+    rec->arg[1] = b;
+    rec->arg[2] = c;
+    if (++traceNext == TraceBufferSize)
+	traceNext = 0;
+    traceTotal++;
+}
+
+//----------------------------------------------------------------------
+// TraceDump
+// 	Write the trace buffer, oldest record first, to a UNIX file, in
+//	the format described in trace.h.  Does nothing if tracing is off.
+//
+//	"fileName" is the file to write.
+//----------------------------------------------------------------------
+
+void
+TraceDump(char *fileName)
+{
+    TraceHeader hdr;
+    int fd;
+
+    if (traceBuffer == NULL)
+	return;
+    hdr.magic = TraceMagic;
+    hdr.version = TraceVersion;
+    hdr.numEvents = NumTraceEvents;
+    hdr.numRecords = (traceTotal < TraceBufferSize) ? traceTotal
+						    : TraceBufferSize;
+    hdr.numLost = traceTotal - hdr.numRecords;
+
+    fd = OpenForWrite(fileName);
+    WriteFile(fd, (char *) &hdr, sizeof(hdr));
+    WriteFile(fd, (char *) traceEvents, sizeof(traceEvents));
+    if (traceTotal > TraceBufferSize)		// wrapped: oldest are next
+	WriteFile(fd, (char *) &traceBuffer[traceNext],
+		  (TraceBufferSize - traceNext) * sizeof(TraceRecord));
+    WriteFile(fd, (char *) traceBuffer, traceNext * sizeof(TraceRecord));
+    Close(fd);
+    printf("Trace: %d records written to %s (%d lost)\n", hdr.numRecords,
+	   fileName, hdr.numLost);
+}
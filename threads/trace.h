@@ -0,0 +1,115 @@
+// trace.h
+//	Data structures for tracing the kernel cheaply.
+//
+//	A trace point records a fixed-size binary record -- the time,
+//	the CPU, the current thread, an event number and three integer
+//	arguments -- into a ring buffer in memory.  Nothing is formatted
+//	while Nachos runs; when it halts, the buffer is written to the
+//	file "nachos.trace", and bin/tracedump turns that into text.
+//
+//	Trace points are grouped by the same flag characters as DEBUG
+//	messages ('t' for threads, 'a' for address spaces and system
+//	calls, and so on), and "-tr <flags>" picks which ones are
+//	recorded.  A trace point that isn't enabled costs a test of one
+//	global word.  Compiling with -DNO_TRACE removes them altogether.
+//
+//	The decoder can also write the trace in the JSON format of the
+//	Chrome/Perfetto trace viewers ("tracedump -j"), with one track
+//	per CPU showing which thread ran when, one track per thread for
+//	its system calls and other events, and one for the disk.  The
+//	timestamps are simulated ticks, shown as microseconds.
+//
+//	The part of this file describing the trace file is plain C, so
+//	that the decoder in bin/ can include it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TraceMagic		0x4e545243	// "NTRC"
+#define TraceVersion		2
+#define TraceBufferSize		65536		// records kept; older ones
+						// are overwritten
+#define TraceFileName		"nachos.trace"
+
+// The events that are traced.  Their names and how to print their
+// arguments are in traceEvents in trace.cc, and are written into the
+// trace file, so the decoder doesn't need to know about them.
+enum TraceEventType {
+    TraceSwitch,		// context switch: a thread starts running
+    TraceStop,			// ... and the previous one stops
+    TraceFork,			// thread forked
+    TraceFinish,		// thread finished
+    TracePageFault,		// page brought into memory
+    TraceSyscall,		// system call
+    TraceAddrSpace,		// address space created
+    TraceSyscallDone,		// system call returns
+    TraceInterrupt,		// interrupt handler called
+    TraceDiskRequest,		// disk read or write started
+    TraceDiskDone,		// ... and finished
+    NumTraceEvents
+};
+
+// One trace record
+typedef struct traceRecord {
+    int time;			// stats->totalTicks
+    short event;		// TraceEventType
+    short cpu;			// processor it happened on
+    int tid;			// current thread, -1 if none yet
+    int arg[3];			// depends on the event
+} TraceRecord;
+
+// How to show an event on a timeline:
+#define TracePhaseInstant	'i'	// a point in time
+#define TracePhaseBegin		'B'	// start of an interval on its track
+#define TracePhaseEnd		'E'	// end of the last interval begun
+#define TraceTrackCPU		'c'	// the CPU it happened on
+#define TraceTrackThread	't'	// the thread that was running
+#define TraceTrackDisk		'd'	// the disk
+
+// How to print an event; the format takes the three arguments
+typedef struct traceEventInfo {
+    char name[16];
+    char format[44];
+    char phase;			// TracePhase...
+    char track;			// TraceTrack...
+    char pad[2];
+} TraceEventInfo;
+
+// The trace file is this header, then numEvents TraceEventInfo's, then
+// numRecords TraceRecord's, oldest first.
+typedef struct traceHeader {
+    int magic;			// should be TraceMagic
+    int version;		// should be TraceVersion
+    int numEvents;		// NumTraceEvents of the writer
+    int numRecords;		// records in the file
+    int numLost;		// older records that were overwritten
+} TraceHeader;
+
+#ifdef __cplusplus
+
+extern unsigned int traceMask;		// bit i set: trace flag 'a' + i
+
+#define TraceBit(flag)	(((flag) == '+') ? ~0U : (1U << ((flag) - 'a')))
+
+extern void TraceInit(char *flags);	// start recording these flags
+extern void TraceEvent(int event, int a, int b, int c);
+					// record one event
+extern void TraceDump(char *fileName);	// write the buffer out
+
+#ifdef NO_TRACE
+#define TRACE(flag, event, a, b, c)
+#else
+#define TRACE(flag, event, a, b, c)					\
+    do {								\
+	if (traceMask & TraceBit(flag))					\
+	    TraceEvent(event, a, b, c);					\
+    } while (0)
+#endif
+
+#endif // __cplusplus
+
+#endif // TRACE_H
@@ -19,10 +19,16 @@
 #include "system.h"
 #include "addrspace.h"
 #include "noff.h"
+#include "pcprof.h"
 #ifdef HOST_SPARC
 #include <strings.h>
 #endif
 
+//Fork出的地址空间和父进程共用已调入内存的物理页。
+//frameSharers[ppn]是除第一个之外还在用该页的地址空间个数，
+//最后一个用它的地址空间析构时才释放
+static int frameSharers[NumPhysPages];
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the 
@@ -164,6 +170,8 @@ AddrSpace::AddrSpace(OpenFile *executable)
     //每个用户空间占用连续的一块虚存，
     //设置用户空间的虚拟页号偏移量
     vpnoffset = machine->swapoffset;
+    profile = NULL;
+    files = new FileTable();
     //设置已使用虚存的页偏移量
     machine->swapoffset += numPages;
     ASSERT(machine->swapoffset <= NumPhysPages);
@@ -252,32 +260,73 @@ AddrSpace::AddrSpace(OpenFile *executable)
         */
     }
     //输出内存占用量
-    printf("[addrspace]thread (%s) creating it's space.\n",currentThread->getName());
+    DEBUG('a', "Thread (%s) created its space.\n",currentThread->getName());
+    TRACE('a', TraceAddrSpace, numPages, vpnoffset, 0);
     //machine->bitmap->PrintUsage();
 }
 
 AddrSpace::AddrSpace(AddrSpace* sp){
     int i;
     numPages = sp->numPages;
+    //和父进程用同一块虚存，缺页时调入同一程序的页
+    vpnoffset = sp->vpnoffset;
     pageTable = new TranslationEntry[numPages];
     for(i = 0; i < numPages; i++){
         pageTable[i] = sp->pageTable[i];
+        if(pageTable[i].valid){
+            frameSharers[pageTable[i].physicalPage]++;
+        }
     }
+    //复制出的进程共享父进程打开的文件
+    files = new FileTable(sp->files);
+    //复制出的进程运行同一程序，另起一份采样
+    profile = NULL;
+    if (sp->profile != NULL)
+        ProfilePC(sp->profile->Name());
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddrSpace
+// 	Create an address space of "nPages" pages, whose contents live
+//	at page "offset" of the swap area.  The page table is left for
+//	the caller to fill in (used when restoring a checkpoint).
+//----------------------------------------------------------------------
+
+AddrSpace::AddrSpace(unsigned int nPages, int offset)
+{
+    numPages = nPages;
+    vpnoffset = offset;
+    pageTable = new TranslationEntry[numPages];
+    profile = NULL;
+    files = new FileTable();
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space, freeing the frames no other address
+//	space shares.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
+#ifdef USE_TLB
+    ShootdownTLB(this);		// no TLB may keep our frames mapped
+#endif
     for(int i = 0; i < numPages; i++){
         if(pageTable[i].valid){
-            machine->bitmap->Clear(pageTable[i].physicalPage);
+            int ppn = pageTable[i].physicalPage;
+            //还有别的地址空间在用，只减少计数
+            if(frameSharers[ppn] > 0){
+                frameSharers[ppn]--;
+            }
+            else{
+                machine->bitmap->Clear(ppn);
+            }
         }
     }
     delete pageTable;
+    delete profile;
+    delete files;
 }
 
 //----------------------------------------------------------------------
@@ -335,4 +384,20 @@ void AddrSpace::RestoreState()
 {
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+    if (profile != NULL)
+	StartPCSampler();
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ProfilePC
+// 	If "-pc" is on, sample the PC of this address space, naming
+//	the samples with the symbols of "programName".  The sampler is
+//	started by RestoreState.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::ProfilePC(char *programName)
+{
+    if (pcSampleInterval > 0)
+	profile = new PCProfile(programName, numPages * PageSize);
 }
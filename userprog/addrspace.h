@@ -15,15 +15,21 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "stats.h"
+#include "filetable.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
+class PCProfile;
+
 class AddrSpace {
   public:
     AddrSpace(OpenFile *executable);	// Create an address space,
 					// initializing it with the program
 					// stored in the file "executable"
     AddrSpace(AddrSpace* sp);
+    AddrSpace(unsigned int nPages, int offset);	// Empty address space,
+					// filled in by RestoreCheckpoint
     ~AddrSpace();			// De-allocate an address space
 
 
@@ -32,6 +38,8 @@ class AddrSpace {
 
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
+
+    void ProfilePC(char *programName);	// sample the PC, if "-pc" is on
     int vpnoffset;
 
   //private:
@@ -39,6 +47,9 @@ class AddrSpace {
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
           // address space
+    ResourceUsage usage;		// what the process has used
+    PCProfile *profile;			// PC samples, NULL if not profiled
+    FileTable *files;			// the files the program has open
     
 };
 
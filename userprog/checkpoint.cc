@@ -0,0 +1,345 @@
+// checkpoint.cc
+//	Routines to save the simulated machine to a file, and to restore
+//	it later on.  See checkpoint.h for what is (and isn't) saved.
+//
+//	The image is written with plain UNIX writes, and read back by
+//	mapping the whole file into memory, so that restoring even a
+//	large machine is a handful of memory copies.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "checkpoint.h"
+#include "syscall.h"
+
+// Pending interrupts collected by SavePending, while walking the
+// interrupt queue
+static CheckpointInterrupt pendingSaved[MaxCheckpointPending];
+static int numPendingSaved;
+static int numPendingSeen;		// including those there was no
+					// room for
+
+// Which types of interrupt are pending now, collected by NotePending
+#define IntTypes (SchedulerInt + 1)
+static bool pendingNow[IntTypes];
+
+//----------------------------------------------------------------------
+// SavePending
+// 	Record one pending interrupt, if there is room; count it in any
+//	case.  Called for each element of the interrupt queue.
+//----------------------------------------------------------------------
+
+static void
+SavePending(int arg)
+{
+    PendingInterrupt *pend = (PendingInterrupt *)arg;
+
+    numPendingSeen++;
+    if (numPendingSaved < MaxCheckpointPending) {
+	pendingSaved[numPendingSaved].type = pend->type;
+	pendingSaved[numPendingSaved].fromNow = pend->when - stats->totalTicks;
+	numPendingSaved++;
+    }
+}
+
+//----------------------------------------------------------------------
+// SaveBytes
+// 	Write "size" bytes to the checkpoint file.  Return FALSE if they
+//	couldn't all be written (the disk is full, say).
+//----------------------------------------------------------------------
+
+static bool
+SaveBytes(int fd, char *buffer, int size)
+{
+    return WritePartial(fd, buffer, size) == size;
+}
+
+//----------------------------------------------------------------------
+// SaveCheckpoint
+// 	Write the state of the machine, and of the address space of the
+//	current thread, to the UNIX file "name".  Return FALSE if the
+//	file can't be written, or if there is state that can't be saved:
+//	other threads alive, files open besides the console, or more
+//	pending interrupts than the checkpoint has room for.
+//
+//	The registers are saved as they are, so the caller should have
+//	already advanced the PC past the system call, and set up the
+//	value the program should see when it is restored.
+//
+//	"name" -- the UNIX file to hold the checkpoint
+//----------------------------------------------------------------------
+
+bool
+SaveCheckpoint(char *name)
+{
+    CheckpointHeader hdr;
+    AddrSpace *space = currentThread->space;
+    TranslationEntry empty;
+    char used[NumPhysPages];
+    int fd, i;
+    bool ok;
+
+    if (space == NULL)
+	return FALSE;
+    if (threadTable->NumThreads() > 1) {
+	printf("Checkpoint: %d threads are alive; only a program running "
+				"alone can be saved.\n", threadTable->NumThreads());
+	return FALSE;
+    }
+
+    for (i = ConsoleOutput + 1; i < MaxOpenFiles; i++)
+	if (space->files->Lookup(i) != NULL) {
+	    printf("Checkpoint: file %d is open; open files can't be "
+				"saved.\n", i);
+	    return FALSE;
+	}
+
+    numPendingSaved = numPendingSeen = 0;
+    interrupt->MapPending(SavePending);
+    if (numPendingSeen > MaxCheckpointPending) {
+	printf("Checkpoint: %d interrupts are pending; only %d can be "
+		"saved.\n", numPendingSeen, MaxCheckpointPending);
+	return FALSE;
+    }
+
+    hdr.magic = CheckpointMagic;
+    hdr.version = CheckpointVersion;
+    hdr.memorySize = MemorySize;
+    hdr.numPhysPages = NumPhysPages;
+    hdr.tlbSize = TLBSize;
+    hdr.numTotalRegs = NumTotalRegs;
+    hdr.numPages = space->numPages;
+    hdr.vpnOffset = space->vpnoffset;
+    hdr.swapOffset = machine->swapoffset;
+    hdr.numPending = numPendingSaved;
+    hdr.numThreads = threadTable->NumThreads();
+    hdr.totalTicks = stats->totalTicks;
+    hdr.idleTicks = stats->idleTicks;
+    hdr.systemTicks = stats->systemTicks;
+    hdr.userTicks = stats->userTicks;
+    hdr.numDiskReads = stats->numDiskReads;
+    hdr.numDiskWrites = stats->numDiskWrites;
+    hdr.numConsoleCharsRead = stats->numConsoleCharsRead;
+    hdr.numConsoleCharsWritten = stats->numConsoleCharsWritten;
+    hdr.numPageFaults = stats->numPageFaults;
+    hdr.numPacketsSent = stats->numPacketsSent;
+    hdr.numPacketsRecvd = stats->numPacketsRecvd;
+    hdr.tlbHit = machine->tlb_hit;
+    hdr.tlbMiss = machine->tlb_miss;
+
+    for (i = 0; i < NumPhysPages; i++)
+	used[i] = machine->bitmap->Test(i) ? 1 : 0;
+    bzero((char *) &empty, sizeof(empty));
+
+    fd = OpenForWrite(name, FALSE);
+    if (fd < 0)
+	return FALSE;
+    ok = SaveBytes(fd, (char *) &hdr, sizeof(hdr))
+	&& SaveBytes(fd, (char *) machine->registers,
+		     NumTotalRegs * sizeof(int));
+    for (i = 0; ok && i < TLBSize; i++) {
+	if (machine->tlb != NULL)
+	    ok = SaveBytes(fd, (char *) &machine->tlb[i],
+			   sizeof(TranslationEntry));
+	else
+	    ok = SaveBytes(fd, (char *) &empty, sizeof(TranslationEntry));
+    }
+    ok = ok && SaveBytes(fd, (char *) machine->LRU_mark, TLBSize * sizeof(int))
+	&& SaveBytes(fd, (char *) space->pageTable,
+		     space->numPages * sizeof(TranslationEntry))
+	&& SaveBytes(fd, used, NumPhysPages)
+	&& SaveBytes(fd, (char *) pendingSaved,
+		     numPendingSaved * sizeof(CheckpointInterrupt))
+	&& SaveBytes(fd, machine->mainMemory, MemorySize)
+	&& SaveBytes(fd, machine->swapspace, MemorySize);
+    Close(fd);
+    if (!ok) {
+	(void) Unlink(name);		// don't leave half an image behind
+	return FALSE;
+    }
+
+    DEBUG('a', "Checkpoint of \"%s\" written to %s at time %d\n",
+				currentThread->getName(), name, hdr.totalTicks);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// NotePending
+// 	Note the type of one interrupt pending now.  Called for each
+//	element of the interrupt queue.
+//----------------------------------------------------------------------
+
+static void
+NotePending(int arg)
+{
+    PendingInterrupt *pend = (PendingInterrupt *)arg;
+
+    pendingNow[pend->type] = TRUE;
+}
+
+//----------------------------------------------------------------------
+// CanRestorePending
+// 	Check that the interrupts pending in a checkpoint can be brought
+//	back.  The polls of the timer, the console and the network are
+//	re-armed by the devices when Nachos starts, and only need to be
+//	re-timed; a time slice is re-armed at the next dispatch.  But an
+//	I/O that was in progress belonged to kernel state that isn't
+//	saved, and so can't be finished.  Print why, and return FALSE,
+//	if the checkpoint can't be restored.
+//
+//	"hdr" is the checkpoint header.
+//	"pend" are the pending interrupts it recorded.
+//----------------------------------------------------------------------
+
+static bool
+CanRestorePending(CheckpointHeader *hdr, CheckpointInterrupt *pend)
+{
+    for (int i = 0; i < IntTypes; i++)
+	pendingNow[i] = FALSE;
+    interrupt->MapPending(NotePending);
+
+    for (int i = 0; i < hdr->numPending; i++) {
+	switch (pend[i].type) {
+	  case TimerInt:
+	  case ConsoleReadInt:
+	  case NetworkRecvInt:
+	    if (!pendingNow[pend[i].type]) {
+		printf("Checkpoint needs a device (interrupt type %d) that "
+			"isn't running; use the same flags as when it was "
+			"saved.\n", pend[i].type);
+		return FALSE;
+	    }
+	    break;
+	  case SchedulerInt:
+	    break;
+	  default:
+	    printf("Checkpoint was taken with an I/O in progress "
+			"(interrupt type %d); it can't be restored.\n",
+			pend[i].type);
+	    return FALSE;
+	}
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RestoreCheckpoint
+// 	Map the checkpoint "name" into memory, load the machine from it,
+//	and give the current thread the saved address space.
+//	Return FALSE if the file isn't a checkpoint of this machine
+//	configuration, or holds state that can't be brought back (see
+//	CanRestorePending).
+//
+//	On return, the caller only needs to call Machine::Run.
+//
+//	"name" -- the UNIX file holding the checkpoint
+//----------------------------------------------------------------------
+
+bool
+RestoreCheckpoint(char *name)
+{
+    CheckpointHeader *hdr;
+    CheckpointInterrupt *pend;
+    AddrSpace *space;
+    char *image, *ptr;
+    int size, expected, i;
+
+    image = MapFile(name, &size);
+    if (image == NULL)
+	return FALSE;
+    hdr = (CheckpointHeader *) image;
+    if (size < (int) sizeof(CheckpointHeader)
+		|| hdr->magic != CheckpointMagic
+		|| hdr->version != CheckpointVersion
+		|| hdr->memorySize != MemorySize
+		|| hdr->numPhysPages != NumPhysPages
+		|| hdr->tlbSize != TLBSize
+		|| hdr->numTotalRegs != NumTotalRegs) {
+	UnmapFile(image, size);
+	return FALSE;
+    }
+    expected = sizeof(CheckpointHeader) + NumTotalRegs * sizeof(int)
+		+ TLBSize * (sizeof(TranslationEntry) + sizeof(int))
+		+ hdr->numPages * sizeof(TranslationEntry) + NumPhysPages
+		+ hdr->numPending * sizeof(CheckpointInterrupt)
+		+ 2 * MemorySize;
+    if (size != expected) {
+	UnmapFile(image, size);
+	return FALSE;
+    }
+    if (hdr->numThreads > 1) {
+	printf("Checkpoint had %d threads; only a single program can be "
+				"restored.\n", hdr->numThreads);
+	UnmapFile(image, size);
+	return FALSE;
+    }
+    // the pending interrupts come just before the two memory images
+    pend = (CheckpointInterrupt *) (image + size - 2 * MemorySize)
+		- hdr->numPending;
+    if (!CanRestorePending(hdr, pend)) {
+	UnmapFile(image, size);
+	return FALSE;
+    }
+
+    ptr = image + sizeof(CheckpointHeader);
+    bcopy(ptr, (char *) machine->registers, NumTotalRegs * sizeof(int));
+    ptr += NumTotalRegs * sizeof(int);
+    if (machine->tlb != NULL)
+	bcopy(ptr, (char *) machine->tlb, TLBSize * sizeof(TranslationEntry));
+    ptr += TLBSize * sizeof(TranslationEntry);
+    bcopy(ptr, (char *) machine->LRU_mark, TLBSize * sizeof(int));
+    ptr += TLBSize * sizeof(int);
+
+    space = new AddrSpace(hdr->numPages, hdr->vpnOffset);
+    bcopy(ptr, (char *) space->pageTable,
+			hdr->numPages * sizeof(TranslationEntry));
+    ptr += hdr->numPages * sizeof(TranslationEntry);
+
+    for (i = 0; i < NumPhysPages; i++) {
+	if (ptr[i])
+	    machine->bitmap->Mark(i);
+	else
+	    machine->bitmap->Clear(i);
+    }
+    ptr += NumPhysPages;
+
+    ptr += hdr->numPending * sizeof(CheckpointInterrupt);	// see below
+
+    bcopy(ptr, machine->mainMemory, MemorySize);
+    ptr += MemorySize;
+    bcopy(ptr, machine->swapspace, MemorySize);
+
+    machine->swapoffset = hdr->swapOffset;
+    machine->tlb_hit = hdr->tlbHit;
+    machine->tlb_miss = hdr->tlbMiss;
+    stats->totalTicks = hdr->totalTicks;
+    stats->idleTicks = hdr->idleTicks;
+    stats->systemTicks = hdr->systemTicks;
+    stats->userTicks = hdr->userTicks;
+    stats->numDiskReads = hdr->numDiskReads;
+    stats->numDiskWrites = hdr->numDiskWrites;
+    stats->numConsoleCharsRead = hdr->numConsoleCharsRead;
+    stats->numConsoleCharsWritten = hdr->numConsoleCharsWritten;
+    stats->numPageFaults = hdr->numPageFaults;
+    stats->numPacketsSent = hdr->numPacketsSent;
+    stats->numPacketsRecvd = hdr->numPacketsRecvd;
+
+    // the devices' polls were armed when we started up; make them due
+    // when they were in the saved run
+    for (i = 0; i < hdr->numPending; i++)
+	if (interrupt->Reschedule((IntType) pend[i].type,
+				  hdr->totalTicks + pend[i].fromNow))
+	    DEBUG('a', "Interrupt of type %d re-armed, due in %d ticks\n",
+				pend[i].type, pend[i].fromNow);
+
+    DEBUG('a', "Restored checkpoint %s at time %d\n", name, hdr->totalTicks);
+    UnmapFile(image, size);
+
+    currentThread->space = space;
+    space->RestoreState();		// load page table register
+    return TRUE;
+}
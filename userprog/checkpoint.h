@@ -0,0 +1,87 @@
+// checkpoint.h
+//	Data structures for saving the simulated machine to a file, and
+//	for restarting from that file later on.
+//
+//	A checkpoint is taken by a user program through the Checkpoint
+//	system call.  It records the state of the simulated hardware
+//	(main memory, the swap area, registers, TLB, the page table of
+//	the calling process, the free page map, simulated time and the
+//	pending interrupts), so that a long warm-up phase only has to be
+//	run once.  "nachos -cr <file>" maps the image back in and resumes
+//	the process right after its Checkpoint call.
+//
+//	Kernel threads run on host stacks, so they can't be saved: the
+//	process calling Checkpoint must be the only thread alive.  Nor
+//	can open files, so it must have only the console open; and no
+//	more than MaxCheckpointPending interrupts may be pending.  The
+//	polls of the timer, console and network are re-armed by the
+//	devices themselves when Nachos starts up, and restoring makes
+//	them due when they were in the saved run; a checkpoint taken
+//	with a disk or output operation in progress is refused when it
+//	is restored, since the kernel state waiting for it is gone.
+//	The simulated disk is already a UNIX file, and the file system
+//	keeps no buffer cache, so there are no file system buffers to save.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define CheckpointMagic		0x4e434b50	// "NCKP"
+#define CheckpointVersion	1
+#define MaxCheckpointPending	32	// pending interrupts we record
+
+// The checkpoint file starts with this header, followed by:
+//	the user registers			(NumTotalRegs ints)
+//	the TLB and its LRU marks		(TLBSize entries, TLBSize ints)
+//	the page table of the process		(numPages entries)
+//	the free page map			(NumPhysPages bytes)
+//	the pending interrupts			(numPending entries)
+//	main memory, then the swap area		(MemorySize bytes each)
+
+typedef struct checkpointHeader {
+    int magic;			// should be CheckpointMagic
+    int version;		// should be CheckpointVersion
+    int memorySize;		// machine configuration, must match
+    int numPhysPages;
+    int tlbSize;
+    int numTotalRegs;
+
+    int numPages;		// size of the process's address space
+    int vpnOffset;		// where its pages live in the swap area
+    int swapOffset;		// first free page of the swap area
+    int numPending;		// # of pending interrupts recorded
+    int numThreads;		// # of threads alive when we were saved
+
+    int totalTicks;		// simulated time
+    int idleTicks;
+    int systemTicks;
+    int userTicks;
+    int numDiskReads;
+    int numDiskWrites;
+    int numConsoleCharsRead;
+    int numConsoleCharsWritten;
+    int numPageFaults;
+    int numPacketsSent;
+    int numPacketsRecvd;
+    int tlbHit;
+    int tlbMiss;
+} CheckpointHeader;
+
+// A pending interrupt, with its time relative to the checkpoint
+typedef struct checkpointInterrupt {
+    int type;			// IntType
+    int fromNow;		// ticks until it was due to fire
+} CheckpointInterrupt;
+
+extern bool SaveCheckpoint(char *name);	// write the image of the
+					// current process to "name"
+extern bool RestoreCheckpoint(char *name);	// load "name" into the
+					// machine, as the current process
+
+#endif // CHECKPOINT_H
@@ -25,6 +25,8 @@
 #include "system.h"
 #include "syscall.h"
 #include "openfile.h"
+#include "checkpoint.h"
+#include "pcprof.h"
 //FIFO置换算法
 int FIFOReplace(){
     for(int i = 0; i < TLBSize-1; i++){
@@ -67,7 +69,10 @@ void UpdatePageTable(){
     //修改页表
     machine->pageTable[vpn].physicalPage = ppn;
     machine->pageTable[vpn].valid = TRUE;
-    printf("[exception]thread (%s) vpn (%d) has been inserted into mainMem (%d)\n",currentThread->getName(),vpn,ppn);
+    DEBUG('a', "Thread (%s) vpn (%d) has been inserted into mainMem (%d)\n",currentThread->getName(),vpn,ppn);
+    TRACE('a', TracePageFault, vpn, ppn, 0);
+    stats->numPageFaults++;
+    currentThread->AddUsage(ResPageFaults, 1);
 }
 
 //TLB缺页处理
@@ -109,19 +114,20 @@ void UpdateTLB(){
 void exec_fork_func(int name){
     char *filename = new char[128];
     filename = (char*)name;
-    printf("[exception]Starting userprog (%s)\n",filename);
+    DEBUG('a', "Starting userprog (%s)\n",filename);
     //打开可执行文件
     OpenFile *file = fileSystem->Open(filename);
     ASSERT(file != NULL);
     //给该文件创建地址空间
     AddrSpace *space = new AddrSpace(file);
+    space->ProfilePC(filename);
     //地址空间赋给当前线程
     currentThread->space = space;
     //初始化系统寄存器
     space->InitRegisters();
     //把地址空间中页表设置为当前页表
     space->RestoreState();
-    printf("[exception]userprog (%s) is running\n",filename);
+    DEBUG('a', "Userprog (%s) is running\n",filename);
     machine->Run();
 }
 
@@ -136,7 +142,6 @@ void SyscallExec(){
     count = 0;
     do{
         machine->ReadMem(base++, 1, &value);
-        printf("%d\n",value);
         count++;
     }while(value != 0);
     base = base-count;
@@ -147,61 +152,31 @@ void SyscallExec(){
             break;
         }
     }
-    //新创建线程
+    //新创建线程，作为当前线程的子线程，pid写入2号寄存器
+    //关中断，子线程在成为子线程之前不会运行；创建失败时返回-1
     Thread *newthread = new Thread("childThread1",0);
-    //在当前线程的子县城数组中加入该子线程
-    bool found = false;
-    for(count=0;count<MaxChildThreadNum;count++){
-        if(currentThread->childThread[count] == NULL){
-            currentThread->childThread[count] = newthread;
-            //将返回值写入2号寄存器
-            machine->WriteRegister(2,(int)newthread);
-            found = true;
-            break;
-        }
-    }
-    //子线程数组满
-    if(!found){
-        printf("[exception]full of children. Exec failed.\n");
-        machine->PCAdvanced();
-        return;
+    DEBUG('a', "Exec (%s)\n",para);
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    if(newthread->Fork(exec_fork_func, (int)para)){
+        machine->WriteRegister(2, currentThread->AddChild(newthread));
+    }else{
+        delete newthread;
+        delete [] para;
+        machine->WriteRegister(2, -1);
     }
-    //更改子线程的父线程
-    newthread->fatherThread = currentThread;
-    printf("%s\n",para);
-    newthread->Fork(exec_fork_func, (int)para);
+    (void) interrupt->SetLevel(oldLevel);
     //delete para;
     machine->PCAdvanced();
 }
 
 //Join系统调用
 void SyscallJoin(){
-    //读取要等待的子线程
-    int id = machine->ReadRegister(4);
-    Thread *cthread = (Thread*)id;
-    bool found = false;
-    int num = -1;
-    //在子线程数组中寻找该线程
-    for(int i = 0; i<MaxChildThreadNum;i++){
-        if(currentThread->childThread[i] == cthread){
-            num = i;
-            found = true;
-            break;
-        }
-    }
-    //没有找到该子线程
-    if(!found){
-        printf("[exception]cannot find child thread (%s). Join failed.\n",cthread->getName());
-        return;
-    }
-    //找到了该线程并且子线程未结束
-    while(num != -1 && currentThread->childThread[num] != NULL ){
-        printf("[exception]thread (%s) is waiting for his child (%s) \n",currentThread->getName(),cthread->getName());
-        currentThread->Yield();
-    }
-    printf("[exception]child thread has been finished. Join success.\n");
-    //ExitCode写回2号寄存器
-    machine->WriteRegister(2,0);
+    //读取要等待的子线程的pid
+    int pid = machine->ReadRegister(4);
+    //睡眠直到子线程结束，得到它的退出码
+    int code = currentThread->Join(pid);
+    //ExitCode写回2号寄存器，不是子线程时为-1
+    machine->WriteRegister(2, code);
 
     machine->PCAdvanced();
 }
@@ -224,9 +199,8 @@ void SyscallCreate(){
         machine->ReadMem(base+i,1,&value);
         para[i] = (char)value;
     }
-    printf("%s\n",para);
     if(fileSystem->Create(para, 128, 0, "")){
-        printf("[exception]create file (%s) succeed.\n",para);
+        DEBUG('a', "Create file (%s) succeed.\n",para);
     }
     else{
         printf("[exception]create file (%s) failed.\n",para);
@@ -253,54 +227,99 @@ void SyscallOpen(){
         machine->ReadMem(base+i,1,&value);
         para[i] = (char)value;
     }
-    //调用文件系统接口打开文件
+    //调用文件系统接口打开文件，放进本进程的打开文件表
     OpenFile *file = fileSystem->Open(para);
+    int fd = -1;
     if(file != NULL){
-        printf("[exception]open file (%s) succeed. id (%d)\n",para, (int)file);
-        //返回参数写入2号寄存器
-        machine->WriteRegister(2,(int)file);
+        FileHandle *handle = new FileHandle(file);
+        fd = currentThread->space->files->Add(handle);
+        if(fd == -1){
+            printf("[exception]too many open files, open (%s) failed.\n",para);
+            delete handle;
+        }
+        else{
+            DEBUG('a', "Open file (%s) succeed. id (%d)\n",para, fd);
+        }
     }
     else{
         printf("[exception]open file (%s) failed.\n",para);
-        machine->WriteRegister(2,0);
     }
+    //返回文件描述符写入2号寄存器，失败为-1
+    machine->WriteRegister(2,fd);
     delete para;
     machine->PCAdvanced();
 }
 
 //Close系统调用
 void SyscallClose(){
-    int value = machine->ReadRegister(4);
-    OpenFile *file = (OpenFile*)value;
-    printf("[exception]closing file id (%d)\n",value);
-    delete file;
+    int fd = machine->ReadRegister(4);
+    DEBUG('a', "Closing file id (%d)\n",fd);
+    if(!currentThread->space->files->Close(fd)){
+        printf("[exception]close file id (%d) is not open.\n",fd);
+    }
     machine->PCAdvanced();
 }
 
+//把用户地址addr所在页调入内存、装入TLB，返回它在mainMemory中的位置；
+//地址不在地址空间内时返回NULL。物理页不会被换出，所以返回的指针在
+//文件系统读写磁盘、线程让出CPU期间一直有效
+static char *UserMemory(int addr, bool writing){
+    int phys;
+    ExceptionType exception;
+    if(addr < 0 || (unsigned)addr / PageSize >= machine->pageTableSize){
+        return NULL;
+    }
+    //TLB缺失时先处理，再重新翻译
+    while((exception = machine->Translate(addr, &phys, 1, writing))
+            == PageFaultException){
+        machine->WriteRegister(BadVAddrReg, addr);
+        UpdateTLB();
+    }
+    if(exception != NoException){
+        return NULL;
+    }
+    return &machine->mainMemory[phys];
+}
+
+//在用户buffer和打开文件之间传送size字节，按页分块，
+//直接读写用户的物理页，不经过内核缓冲区。返回传送的字节数，
+//buffer非法时为-1
+static int UserTransfer(FileHandle *file, int buffer, int size, bool reading){
+    int done = 0;
+    while(done < size){
+        int addr = buffer + done;
+        //本块不跨页
+        int chunk = min(size - done, PageSize - addr % PageSize);
+        char *frame = UserMemory(addr, reading);
+        if(frame == NULL){
+            printf("[exception]bad buffer address (%d)\n",addr);
+            return (done > 0) ? done : -1;
+        }
+        int n = reading ? file->Read(frame, chunk) : file->Write(frame, chunk);
+        done += n;
+        //文件读完，或控制台读到一行
+        if(n < chunk){
+            break;
+        }
+    }
+    return done;
+}
+
 //Write系统调用
 void SyscallWrite(){
     int bufferbase = machine->ReadRegister(4);
     int size = machine->ReadRegister(5);
     int fd = machine->ReadRegister(6);
-    char *contents = new char[128];
-    int i,value;
-    //获取buffer内容
-    for(i=0;i<size;i++){
-        machine->ReadMem(bufferbase+i, 1, &value);
-        contents[i] = (char)value;
-    }
-    contents[i] = '\0';
 
-    OpenFile* file = (OpenFile*)fd;
+    FileHandle *file = currentThread->space->files->Lookup(fd);
     if(file == NULL){
-        printf("[exception]write file id is null. Write failed\n");
+        printf("[exception]write file id (%d) is not open. Write failed\n",fd);
     }
     else{
-        printf("[exception]writing contents (%s)\n",contents);
+        DEBUG('a', "Writing (%d) bytes from buffer to file\n",size);
         //写文件
-        file->Write(contents, size);
+        UserTransfer(file, bufferbase, size, FALSE);
     }
-    delete contents;
     machine->PCAdvanced();
 }
 
@@ -309,34 +328,21 @@ void SyscallRead(){
     int bufferbase = machine->ReadRegister(4);
     int size = machine->ReadRegister(5);
     int fd = machine->ReadRegister(6);
-    char *contents = new char[128];
-    int i,value;
-    OpenFile* openfile = (OpenFile*)fd;
+    FileHandle *openfile = currentThread->space->files->Lookup(fd);
     if(openfile == NULL){
-        printf("[exception]read file id is null. Read failed\n");
+        printf("[exception]read file id (%d) is not open. Read failed\n",fd);
+        machine->WriteRegister(2, -1);
     }
     else{
-        printf("[exception]reading (%d) bytes from file to buffer\n",size);
-        //从文件读进缓冲区
-        i = openfile->Read(contents, size);
-        contents[size] = '\0';
-        //读出字节数写回2号寄存器
-        machine->WriteRegister(2, i);
-        //printf("[exception]contents (%s)\n",contents);
-        for(i = 0; i < size; i++){
-            value = (int)contents[i];
-            machine->WriteMem(bufferbase+i, 1, value);
-        }
-        //字符串结尾写入内存
-        machine->WriteMem(bufferbase+i, 1, 0);
-        printf("[exception]write contents to Nachos mainMemory\n");
+        DEBUG('a', "Reading (%d) bytes from file to buffer\n",size);
+        //从文件直接读进用户内存，读出字节数写回2号寄存器
+        machine->WriteRegister(2, UserTransfer(openfile, bufferbase, size, TRUE));
     }
-    delete contents;
     machine->PCAdvanced();
 }
 
 void fork_func(int pc){
-    printf("[exception]child thread fork\n");
+    DEBUG('a', "Child thread fork\n");
     //设置子线程空间
     AddrSpace* sp = currentThread->fatherThread->space;
     AddrSpace* space = new AddrSpace(sp);
@@ -345,42 +351,76 @@ void fork_func(int pc){
     machine->WriteRegister(PCReg, pc);
     machine->WriteRegister(NextPCReg, pc+4);
     //保存线程状态
-    printf("[exception]child thread start running.\n");
+    DEBUG('a', "Child thread start running.\n");
     machine->Run();
 }
 //Fork系统调用
 void SyscallFork(){
-    int i;
     //读取子线程函数的指令地址
     int PC = machine->ReadRegister(4);
     //创建子线程
     Thread *cthread = new Thread("childThread2", 0);
-    bool found = false;
-    //子线程添加到当前线程的子线程数组中
-    for(i = 0; i < MaxChildThreadNum; i++){
-        if(currentThread->childThread[i] == NULL){
-            currentThread->childThread[i] = cthread;
-            found = true;
+    //子线程加入当前线程的子线程表，关中断使它在此之前不会运行
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    if(cthread->Fork(fork_func, PC)){
+        currentThread->AddChild(cthread);
+    }else{
+        delete cthread;
+    }
+    (void) interrupt->SetLevel(oldLevel);
+
+    machine->PCAdvanced();
+}
+
+
+//Checkpoint系统调用
+void SyscallCheckpoint(){
+    int base = machine->ReadRegister(4);
+    int value;
+    int i;
+    char *para = new char[128];
+    //逐个字节读取文件名
+    for(i = 0; i < 127; i++){
+        machine->ReadMem(base+i, 1, &value);
+        para[i] = (char)value;
+        if(para[i] == '\0'){
             break;
         }
     }
-    if(!found){
-        printf("[exception]full of children. Exec failed.\n");
-        machine->PCAdvanced();
-        return;
+    para[i] = '\0';
+    //先移动PC，恢复时从系统调用的下一条指令继续执行，返回值为1
+    machine->PCAdvanced();
+    machine->WriteRegister(2, 1);
+    if(SaveCheckpoint(para)){
+        machine->WriteRegister(2, 0);
+    }
+    else{
+        printf("[exception]checkpoint (%s) failed.\n",para);
+        machine->WriteRegister(2, -1);
     }
-    //子线程的父线程赋值
-    cthread->fatherThread = currentThread;
-    cthread->Fork(fork_func, PC);
+    delete para;
+}
 
+//GetStats系统调用：把当前进程的资源使用计数写到用户内存
+void SyscallGetStats(){
+    int base = machine->ReadRegister(4);
+    int n = machine->ReadRegister(5);
+    int i;
+    if(n > NumResources){
+        n = NumResources;
+    }
+    for(i = 0; i < n; i++){
+        machine->WriteMem(base + i * 4, 4, currentThread->space->usage.count[i]);
+    }
+    //返回写入的计数个数
+    machine->WriteRegister(2, (n > 0) ? n : 0);
     machine->PCAdvanced();
 }
 
-
 //Yield系统调用
 void SyscallYield(){
     machine->PCAdvanced();
-    printf("[exception]thread (%s) yield.\n",currentThread->getName());
+    DEBUG('a', "Thread (%s) yield.\n",currentThread->getName());
     currentThread->Yield();
 }
 
@@ -414,6 +454,9 @@ ExceptionHandler(ExceptionType which)
     int type = machine->ReadRegister(2);
 
     if (which == SyscallException) {
+        TRACE('a', TraceSyscall, type, machine->ReadRegister(4),
+              machine->ReadRegister(5));
+        currentThread->AddUsage(ResSyscalls, 1);
         switch(type){
         case SC_Halt:
             DEBUG('a', "Shutdown, initiated by user program.\n");
@@ -423,8 +466,8 @@ ExceptionHandler(ExceptionType which)
             DEBUG('a', "user program is done.\n");
             int code;
             code = machine->ReadRegister(4);
-            printf("[exception]thread (%s) exit. Code (%d)\n",currentThread->getName(),code);
-            currentThread->Finish();
+            DEBUG('a', "Thread (%s) exit. Code (%d)\n",currentThread->getName(),code);
+            currentThread->Finish(code);
             machine->PCAdvanced();
             break;
         case SC_Exec:
@@ -454,10 +497,17 @@ ExceptionHandler(ExceptionType which)
         case SC_Yield:
             SyscallYield();
             break;
+        case SC_Checkpoint:
+            SyscallCheckpoint();
+            break;
+        case SC_GetStats:
+            SyscallGetStats();
+            break;
         default:
             printf("Unexpected user mode exception %d %d\n", which, type);
 	        ASSERT(FALSE);
         }
+        TRACE('a', TraceSyscallDone, machine->ReadRegister(2), 0, 0);
     }
     else if(which == PageFaultException){
         //TLB缺页处理
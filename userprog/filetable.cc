@@ -0,0 +1,213 @@
+// filetable.cc
+//	Routines to manage the open files of a user program.  See
+//	filetable.h for how descriptors, handles and files relate.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "filetable.h"
+#include "synchconsole.h"
+#include "syscall.h"
+#include "system.h"
+
+// The console all user programs share.  It is only started when a
+// program first uses it, since once it is polling for input, Nachos
+// never runs out of things to do and has to be halted explicitly.
+static SynchConsole *userConsole = NULL;
+
+static SynchConsole *
+UserConsole()
+{
+    if (userConsole == NULL)
+	userConsole = new SynchConsole(NULL, NULL);	// stdin, stdout
+    return userConsole;
+}
+
+//----------------------------------------------------------------------
+// FileHandle::FileHandle
+// 	Initialize a handle on a Nachos file, or on the console.  The
+//	handle starts with no table entries referring to it.
+//
+//	"openFile" is the open Nachos file.
+//	"consoleId" is ConsoleInput or ConsoleOutput.
+//----------------------------------------------------------------------
+
+FileHandle::FileHandle(OpenFile *openFile)
+{
+    file = openFile;
+    console = -1;
+    refCount = 0;
+}
+
+FileHandle::FileHandle(int consoleId)
+{
+    ASSERT(consoleId == ConsoleInput || consoleId == ConsoleOutput);
+    file = NULL;
+    console = consoleId;
+    refCount = 0;
+}
+
+//----------------------------------------------------------------------
+// FileHandle::~FileHandle
+// 	Close the Nachos file.  The console stays open for the others.
+//----------------------------------------------------------------------
+
+FileHandle::~FileHandle()
+{
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// FileHandle::Unref
+// 	A table entry no longer refers to this handle; delete it if it
+//	was the last one.
+//----------------------------------------------------------------------
+
+void
+FileHandle::Unref()
+{
+    ASSERT(refCount > 0);
+    if (--refCount == 0)
+	delete this;
+}
+
+//----------------------------------------------------------------------
+// FileHandle::Read
+// 	Read up to "numBytes" bytes into "into", returning how many
+//	were read.  The console waits for the first character, and
+//	returns after a newline, so that a program reading a line at a
+//	time doesn't wait for more than was typed.  Writing to the
+//	console's input, or reading from its output, does nothing.
+//----------------------------------------------------------------------
+
+int
+FileHandle::Read(char *into, int numBytes)
+{
+    int i;
+
+    if (file != NULL)
+	return file->Read(into, numBytes);
+    if (console != ConsoleInput)
+	return 0;
+    for (i = 0; i < numBytes; ) {
+	into[i] = UserConsole()->GetChar();
+	if (into[i++] == '\n')
+	    break;
+    }
+    return i;
+}
+
+//----------------------------------------------------------------------
+// FileHandle::Write
+// 	Write "numBytes" bytes from "from", returning how many were
+//	written.
+//----------------------------------------------------------------------
+
+int
+FileHandle::Write(char *from, int numBytes)
+{
+    if (file != NULL)
+	return file->Write(from, numBytes);
+    if (console != ConsoleOutput)
+	return 0;
+    for (int i = 0; i < numBytes; i++)
+	UserConsole()->PutChar(from[i]);
+    return numBytes;
+}
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize the table of a new program, with ConsoleInput and
+//	ConsoleOutput open.
+//----------------------------------------------------------------------
+
+FileTable::FileTable()
+{
+    for (int i = 0; i < MaxOpenFiles; i++)
+	handles[i] = NULL;
+    handles[ConsoleInput] = new FileHandle(ConsoleInput);
+    handles[ConsoleInput]->Ref();
+    handles[ConsoleOutput] = new FileHandle(ConsoleOutput);
+    handles[ConsoleOutput]->Ref();
+}
+
+//----------------------------------------------------------------------
+// FileTable::FileTable
+// 	Initialize the table of a forked program: the same files open
+//	under the same ids, sharing their seek positions.
+//
+//	"parent" is the table to copy.
+//----------------------------------------------------------------------
+
+FileTable::FileTable(FileTable *parent)
+{
+    for (int i = 0; i < MaxOpenFiles; i++) {
+	handles[i] = parent->handles[i];
+	if (handles[i] != NULL)
+	    handles[i]->Ref();
+    }
+}
+
+//----------------------------------------------------------------------
+// FileTable::~FileTable
+// 	Close whatever the program left open.
+//----------------------------------------------------------------------
+
+FileTable::~FileTable()
+{
+    for (int i = 0; i < MaxOpenFiles; i++)
+	if (handles[i] != NULL)
+	    handles[i]->Unref();
+}
+
+//----------------------------------------------------------------------
+// FileTable::Add
+// 	Open "handle" under the lowest free id, and return the id; or
+//	return -1 if all the ids are in use.
+//----------------------------------------------------------------------
+
+int
+FileTable::Add(FileHandle *handle)
+{
+    for (int i = 0; i < MaxOpenFiles; i++)
+	if (handles[i] == NULL) {
+	    handles[i] = handle;
+	    handle->Ref();
+	    return i;
+	}
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FileTable::Lookup
+// 	Return the handle open under "fd", or NULL if "fd" is out of
+//	range or not open.
+//----------------------------------------------------------------------
+
+FileHandle *
+FileTable::Lookup(int fd)
+{
+    if (fd < 0 || fd >= MaxOpenFiles)
+	return NULL;
+    return handles[fd];
+}
+
+//----------------------------------------------------------------------
+// FileTable::Close
+// 	Free the id "fd", closing its handle if nothing else refers to
+//	it.  Return FALSE if "fd" wasn't open.
+//----------------------------------------------------------------------
+
+bool
+FileTable::Close(int fd)
+{
+    FileHandle *handle = Lookup(fd);
+
+    if (handle == NULL)
+	return FALSE;
+    handles[fd] = NULL;
+    handle->Unref();
+    return TRUE;
+}
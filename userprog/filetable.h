@@ -0,0 +1,66 @@
+// filetable.h
+//	Data structures for the files a user program has open.
+//
+//	Each address space has a table of open files, indexed by the
+//	small integers (OpenFileId's) that the Open system call returns
+//	and Read, Write and Close take.  Entries 0 and 1 start out open
+//	on the console, for reading and writing (see syscall.h).
+//
+//	A table entry points to a FileHandle, which holds the Nachos
+//	OpenFile and so the seek position.  A process made by Fork gets
+//	a copy of its parent's table, whose entries point to the same
+//	handles; a handle is closed when the last entry pointing to it is.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+#include "openfile.h"
+
+#define MaxOpenFiles	16	// entries in each table
+
+// An open file, or the console, shared by the table entries that
+// refer to it.
+class FileHandle {
+  public:
+    FileHandle(OpenFile *openFile);	// a Nachos file, closed when the
+					// handle is
+    FileHandle(int consoleId);		// the console: ConsoleInput or
+					// ConsoleOutput
+    ~FileHandle();
+
+    int Read(char *into, int numBytes);	// like OpenFile::Read; reading
+					// the console waits for a
+					// character, and stops at a newline
+    int Write(char *from, int numBytes);	// like OpenFile::Write
+
+    void Ref() { refCount++; }		// one more entry refers to us
+    void Unref();			// one fewer; delete us if none do
+
+  private:
+    OpenFile *file;			// NULL for the console
+    int console;			// which way the console is open
+    int refCount;			// entries referring to us
+};
+
+class FileTable {
+  public:
+    FileTable();			// a table with the console open
+    FileTable(FileTable *parent);	// a copy of "parent"'s table
+    ~FileTable();			// close everything still open
+
+    int Add(FileHandle *handle);	// put "handle" in the lowest free
+					// entry; -1 if the table is full
+    FileHandle *Lookup(int fd);		// the handle of "fd", or NULL if
+					// "fd" isn't open
+    bool Close(int fd);			// FALSE if "fd" isn't open
+
+  private:
+    FileHandle *handles[MaxOpenFiles];	// NULL if the entry is free
+};
+
+#endif // FILETABLE_H
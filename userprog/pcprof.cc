@@ -0,0 +1,228 @@
+// pcprof.cc
+//	Routines to sample the PC of user programs, and to print where
+//	they spent their time.  See pcprof.h for how it is used.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "system.h"
+#include "addrspace.h"
+#include "pcprof.h"
+#include "noff.h"
+
+int pcSampleInterval = 0;		// not sampling
+
+static bool sampleOutstanding = FALSE;	// is a sample scheduled?
+
+//----------------------------------------------------------------------
+// PCSampleHandler
+// 	Interrupt handler for the sampler: count the PC of the user
+//	program that was interrupted, and schedule the next sample.
+//
+//	If the machine was idle, or running a thread with no profiled
+//	address space, stop; the next profiled process to be switched
+//	in starts the sampler again.
+//----------------------------------------------------------------------
+
+static void
+PCSampleHandler(int dummy)
+{
+    AddrSpace *space = currentThread->space;
+    MachineStatus was = interrupt->getInterruptedStatus();
+
+    sampleOutstanding = FALSE;
+    if (was == IdleMode || space == NULL || space->profile == NULL)
+	return;
+    space->profile->Sample(machine->ReadRegister(PCReg), was != UserMode);
+    StartPCSampler();
+}
+
+//----------------------------------------------------------------------
+// StartPCSampler
+// 	Schedule the next sample, unless sampling is off or one is
+//	already scheduled.  Called when a profiled address space is
+//	switched in.
+//----------------------------------------------------------------------
+
+void
+StartPCSampler()
+{
+    if (pcSampleInterval > 0 && !sampleOutstanding) {
+	interrupt->Schedule(PCSampleHandler, 0, pcSampleInterval, TimerInt);
+	sampleOutstanding = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// PCProfile::PCProfile
+// 	Set up an empty histogram for an address space of "size" bytes,
+//	and map in the symbols of "programName", if coff2noff left any.
+//----------------------------------------------------------------------
+
+PCProfile::PCProfile(char *programName, int size)
+{
+    char symFileName[80];
+    NoffSymHeader *hdr;
+
+    strncpy(program, programName, sizeof(program) - 1);
+    program[sizeof(program) - 1] = '\0';
+    numInstrs = size / 4;
+    counts = new int[numInstrs];
+    bzero((char *) counts, numInstrs * sizeof(int));
+    samples = kernelSamples = outside = 0;
+
+    symbols = NULL;
+    numSymbols = 0;
+    names = NULL;
+    sprintf(symFileName, "%s.sym", program);
+    image = MapFile(symFileName, &imageSize);
+    if (image == NULL)
+	return;
+    hdr = (NoffSymHeader *) image;
+    if (imageSize < (int) sizeof(NoffSymHeader)
+		|| hdr->magic != NOFFSYMMAGIC
+		|| imageSize != (int) (sizeof(NoffSymHeader)
+			+ hdr->numSymbols * sizeof(NoffSymbol)
+			+ hdr->namesSize)) {
+	printf("%s is not a symbol file; PCs won't be named.\n", symFileName);
+	UnmapFile(image, imageSize);
+	image = NULL;
+	return;
+    }
+    symbols = (NoffSymbol *) (image + sizeof(NoffSymHeader));
+    numSymbols = hdr->numSymbols;
+    names = (char *) (symbols + numSymbols);
+}
+
+//----------------------------------------------------------------------
+// PCProfile::~PCProfile
+//----------------------------------------------------------------------
+
+PCProfile::~PCProfile()
+{
+    delete [] counts;
+    if (image != NULL)
+	UnmapFile(image, imageSize);
+}
+
+//----------------------------------------------------------------------
+// PCProfile::Sample
+// 	Count one sample of the program's PC.
+//
+//	"inKernel" is TRUE if the process was in the kernel; the PC is
+//	then that of the system call, or of the instruction that faulted.
+//----------------------------------------------------------------------
+
+void
+PCProfile::Sample(int pc, bool inKernel)
+{
+    samples++;
+    if (inKernel)
+	kernelSamples++;
+    if (pc < 0 || pc / 4 >= numInstrs)
+	outside++;
+    else
+	counts[pc / 4]++;
+}
+
+//----------------------------------------------------------------------
+// PCProfile::Lookup
+// 	Return the index of the procedure holding "pc": the last one
+//	starting at or before it.  -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+PCProfile::Lookup(int pc)
+{
+    int lo = 0, hi = numSymbols - 1, mid;
+
+    if (numSymbols == 0 || pc < symbols[0].value)
+	return -1;
+    while (lo < hi) {			// symbols[lo].value <= pc
+	mid = (lo + hi + 1) / 2;
+	if (symbols[mid].value <= pc)
+	    lo = mid;
+	else
+	    hi = mid - 1;
+    }
+    return lo;
+}
+
+//----------------------------------------------------------------------
+// Largest
+// 	Return the index of the largest positive element of "a", or -1
+//	if there is none.
+//----------------------------------------------------------------------
+
+static int
+Largest(int *a, int n)
+{
+    int best = -1;
+
+    for (int i = 0; i < n; i++)
+	if (a[i] > 0 && (best < 0 || a[i] > a[best]))
+	    best = i;
+    return best;
+}
+
+//----------------------------------------------------------------------
+// PCProfile::Print
+// 	Print the procedures and the instructions with the most samples,
+//	and their share of all the samples.
+//
+//	"threadName" is the thread running the program.
+//----------------------------------------------------------------------
+
+void
+PCProfile::Print(char *threadName)
+{
+    int *procs = new int[numSymbols + 1];	// the last is "unknown"
+    int *instrs = new int[numInstrs];
+    int i, j, proc;
+
+    printf("\nPC profile of %s (thread %s): %d samples, one every %d ticks, "
+		"%d in the kernel\n", program, threadName, samples,
+		pcSampleInterval, kernelSamples);
+    if (samples == 0) {
+	delete [] procs;
+	delete [] instrs;
+	return;
+    }
+    if (outside > 0)
+	printf("%d samples outside the address space\n", outside);
+
+    bzero((char *) procs, (numSymbols + 1) * sizeof(int));
+    for (i = 0; i < numInstrs; i++) {
+	proc = Lookup(i * 4);
+	procs[(proc < 0) ? numSymbols : proc] += counts[i];
+    }
+    printf("  %-32s %8s %6s\n", "Procedure", "Samples", "%");
+    for (j = 0; j < PCProfileTop && (i = Largest(procs, numSymbols + 1)) >= 0;
+									j++) {
+	printf("  %-32s %8d %6.2f\n", (i < numSymbols)
+		? &names[symbols[i].name] : "(unknown)", procs[i],
+		procs[i] * 100.0 / samples);
+	procs[i] = 0;
+    }
+
+    bcopy((char *) counts, (char *) instrs, numInstrs * sizeof(int));
+    printf("  %-10s %-21s %8s %6s\n", "PC", "Where", "Samples", "%");
+    for (j = 0; j < PCProfileTop && (i = Largest(instrs, numInstrs)) >= 0;
+									j++) {
+	char where[64];
+
+	proc = Lookup(i * 4);
+	if (proc < 0)
+	    sprintf(where, "?");
+	else
+	    sprintf(where, "%.40s+0x%x", &names[symbols[proc].name],
+					i * 4 - symbols[proc].value);
+	printf("  0x%08x %-21s %8d %6.2f\n", i * 4, where, instrs[i],
+		instrs[i] * 100.0 / samples);
+	instrs[i] = 0;
+    }
+    delete [] procs;
+    delete [] instrs;
+}
@@ -0,0 +1,63 @@
+// pcprof.h
+//	Data structures for a sampling profiler of user programs.
+//
+//	With "-pc <ticks>", an interrupt every <ticks> of simulated time
+//	looks at the PC of the running user program, and counts it in a
+//	histogram kept by the program's address space.  Samples taken
+//	while the process is in the kernel (in a system call, or handling
+//	a page fault) are counted apart.  The sampler stops while no user
+//	program is running, so that it can't keep an idle Nachos alive,
+//	and starts again when one is switched in.
+//
+//	The PCs are named with the procedures coff2noff saves next to
+//	the program, in "<program>.sym" (see bin/noff.h).  The file is
+//	read from the UNIX file system.  When a process exits, or Nachos
+//	halts, its busiest procedures and instructions are printed.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PCPROF_H
+#define PCPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define PCProfileTop		10	// procedures and instructions printed
+
+extern int pcSampleInterval;		// ticks between samples, 0 if off
+extern void StartPCSampler();		// sample, if not already doing so
+
+// The following class holds the PC samples of one address space, and
+// the symbols to name them with.
+
+class PCProfile {
+  public:
+    PCProfile(char *programName, int size);
+				// no samples yet, for a program of
+				// "size" bytes; load its symbols
+    ~PCProfile();
+
+    void Sample(int pc, bool inKernel);	// count one sample
+    void Print(char *threadName);	// print the hot spots
+    char *Name() { return program; }
+
+  private:
+    int Lookup(int pc);		// the procedure holding pc, -1 if none
+
+    char program[64];		// the executable, truncated
+    int *counts;		// samples of each instruction
+    int numInstrs;
+    int samples;		// all samples ...
+    int kernelSamples;		// ... of which in the kernel
+    int outside;		// ... of which with a PC outside the space
+
+    char *image;		// the mapped symbol file, NULL if none
+    int imageSize;
+    struct noffSymbol *symbols;	// sorted by address
+    int numSymbols;
+    char *names;
+};
+
+#endif // PCPROF_H
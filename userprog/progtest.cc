@@ -12,6 +12,8 @@
 #include "system.h"
 #include "synchconsole.h"
 #include "addrspace.h"
+#include "checkpoint.h"
+#include "pcprof.h"
 
 
 //----------------------------------------------------------------------
@@ -32,6 +34,7 @@ StartProcess(char *filename)
         return;
     }
     space = new AddrSpace(executable); 
+    space->ProfilePC(filename);
     currentThread->space = space;
 
     delete executable;			// close file
@@ -44,6 +47,23 @@ StartProcess(char *filename)
 					// by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// RestoreProcess
+// 	Resume a user program from a checkpoint written by the
+//	Checkpoint system call.
+//----------------------------------------------------------------------
+
+void
+RestoreProcess(char *checkpoint)
+{
+    if (!RestoreCheckpoint(checkpoint)) {
+        printf("Unable to restore checkpoint %s\n", checkpoint);
+        return;
+    }
+    machine->Run();			// resume the user program
+    ASSERT(FALSE);			// machine->Run never returns
+}
+
 // Data structures needed for the console test.  Threads making
 // I/O requests wait on a Semaphore to delay until the I/O completes.
 
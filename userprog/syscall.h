@@ -29,6 +29,22 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
+#define SC_Checkpoint	11
+#define SC_GetStats	12
+
+/* The counters returned by GetStats, in order (see Resource in stats.h) */
+#define STAT_USER_TICKS		0	/* time running user code */
+#define STAT_SYSTEM_TICKS	1	/* time running in the kernel */
+#define STAT_WAIT_TICKS		2	/* time ready, waiting for the CPU */
+#define STAT_PAGE_FAULTS	3	/* pages brought into memory */
+#define STAT_TLB_MISSES		4
+#define STAT_DISK_READS		5	/* disk sectors read and written */
+#define STAT_DISK_WRITES	6
+#define STAT_SYSCALLS		7
+#define STAT_SWITCHES		8	/* times given the CPU */
+#define STAT_CACHE_ACCESSES	9	/* with "-cache": memory accesses */
+#define STAT_CACHE_MISSES	10
+#define NUM_STATS		11
 
 #ifndef IN_ASM
 
@@ -60,7 +76,8 @@ typedef int SpaceId;
 SpaceId Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status, or -1 if "id" isn't a child of ours that 
+ * hasn't been joined yet.
  */
 int Join(SpaceId id); 	
  
@@ -90,7 +107,7 @@ typedef int OpenFileId;
 void Create(char *name);
 
 /* Open the Nachos file "name", and return an "OpenFileId" that can 
- * be used to read and write to the file.
+ * be used to read and write to the file, or -1 if it can't be opened.
  */
 OpenFileId Open(char *name);
 
@@ -124,6 +141,18 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+/* Save the whole machine to the UNIX file "name", so that "nachos -cr name"
+ * can later resume this program right here.  Returns 0 once the checkpoint
+ * is written, 1 when the program is resumed from it, and -1 on error (the
+ * file can't be written, or other threads are alive).
+ */
+int Checkpoint(char *name);
+
+/* Copy the first "n" resource counters of this program (see STAT_* above)
+ * into "counts".  Returns the number of counters copied.
+ */
+int GetStats(int *counts, int n);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */